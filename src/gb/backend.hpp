@@ -0,0 +1,67 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+#include "block_cache.hpp"
+#include "idioms.hpp"
+#include "jit.hpp"
+
+#include <array>
+#include <string>
+
+// Finds and executes the instructions at pc. Registers, flags and
+// memory stay with CP and MM; a backend only owns what it decoded or
+// translated, so backends can be swapped between any two ticks.
+class Backend
+{
+public:
+  enum class Kind {
+    Reference, // fetch and decode every instruction from memory
+    Cached,    // predecoded blocks, copy and fill loops in bulk
+    Jit,       // cached plus x86-64 translation of hot blocks
+  };
+
+  typedef std::array<Idioms::Stats, Idioms::COUNT> idiom_stats_t;
+
+  virtual ~Backend() = default;
+
+  virtual Kind kind() const = 0;
+
+  // drops everything decoded, the cpu was powered on
+  virtual void reset() = 0;
+
+  // executes at least one instruction and leaves the cycles it takes
+  // in the cpu
+  virtual void step() = 0;
+
+  virtual BlockCache::Stats const* block_stats() const { return nullptr; }
+  virtual idiom_stats_t const* idiom_stats() const { return nullptr; }
+  virtual JitStats const* jit_stats() const { return nullptr; }
+
+  virtual Error save_code_cache(std::string const&) const { return Error::NoError(); }
+  virtual Error load_code_cache(std::string const&) { return Error::NoError(); }
+  virtual void jit_verify(bool) {}
+
+  static char const* name(Kind kind)
+  {
+    switch (kind) {
+    case Kind::Reference: return "reference";
+    case Kind::Cached:    return "cached";
+    case Kind::Jit:       return "jit";
+    }
+
+    return "unknown";
+  }
+
+  static bool parse(std::string const& name, Kind& kind)
+  {
+    for (auto k : { Kind::Reference, Kind::Cached, Kind::Jit }) {
+      if (name == Backend::name(k)) {
+        kind = k;
+        return true;
+      }
+    }
+
+    return false;
+  }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "types.h"
+#include "mm.hpp"
+#include "cp.hpp"
+#include "backend.hpp"
+#include "block_cache.hpp"
+#include "jit.hpp"
+
+#include <string>
+
+// Decodes every instruction from memory right before executing it.
+// Slow, but it has no state that could go stale, which makes it the
+// one the others are compared against.
+class ReferenceBackend : public Backend
+{
+public:
+  ReferenceBackend(CP& cp, MM& mm)
+    : _cp(cp)
+    , _mm(mm)
+  {}
+
+  Kind kind() const override { return Kind::Reference; }
+
+  void reset() override {}
+
+  void step() override
+  {
+    _cp._ins = BlockCache::decode(_mm, _cp._pc);
+    _cp._execute();
+  }
+
+private:
+  CP& _cp;
+  MM& _mm;
+};
+
+// Executes predecoded blocks and runs tagged copy and fill loops in bulk.
+class CachedBackend : public Backend
+{
+public:
+  CachedBackend(CP& cp, MM& mm)
+    : _cp(cp)
+    , _mm(mm)
+    , _bc(mm)
+  {}
+
+  Kind kind() const override { return Kind::Cached; }
+
+  void reset() override
+  {
+    _bc.clear();
+    _block       = nullptr;
+    _idiom_stats = {};
+  }
+
+  void step() override
+  {
+    if (not _next_in_block()) {
+      _block             = _bc.lookup(_cp._pc);
+      _block_pos         = 0;
+      _block_map_version = _mm.map_version();
+
+      if (not _block) {
+        _cp._ins = BlockCache::decode(_mm, _cp._pc);
+        _cp._execute();
+        return;
+      }
+
+      auto const bulk_ticks = _cp._bulk_ticks();
+      if (bulk_ticks > 0) {
+        if (_block->idiom != Idioms::Kind::None and _run_idiom(*_block, bulk_ticks)) {
+          _block_pos = _block->ins.size();
+          return;
+        }
+
+        if (_block->bank != MM::BANK_RAM) {
+          _block_pos = _run_native(*_block, bulk_ticks);
+          if (_block_pos > 0)
+            return;
+        }
+      }
+
+      _cp._ins   = _block->ins.front();
+      _block_pos = 1;
+    }
+
+    _cp._execute();
+  }
+
+  BlockCache::Stats const* block_stats() const override { return &_bc.stats(); }
+  idiom_stats_t const* idiom_stats() const override { return &_idiom_stats; }
+
+  Error save_code_cache(std::string const& path) const override
+  {
+    return _bc.save(path);
+  }
+
+  // must be called after power_on; loaded blocks start out close to hot
+  Error load_code_cache(std::string const& path) override
+  {
+    return _bc.load(path, Jit<CP>::HOT_THRESHOLD - 1);
+  }
+
+protected:
+  // runs a translation of block that takes at most max_ticks and returns
+  // the number of instructions it covered, 0 to interpret it
+  virtual size_t _run_native(BlockCache::Block&, uint32_t)
+  {
+    return 0;
+  }
+
+private:
+  bool _next_in_block()
+  {
+    if (not _block or _block_pos >= _block->ins.size())
+      return false;
+
+    auto const& ins = _block->ins[_block_pos];
+    if (ins.pc != _cp._pc or
+        _mm.map_version() != _block_map_version or
+        not _bc.is_valid(*_block))
+      return false;
+
+    _cp._ins = ins;
+    ++_block_pos;
+    return true;
+  }
+
+  bool _run_idiom(BlockCache::Block const& block, uint32_t max_ticks)
+  {
+    auto const n = _cp._run_idiom(block, max_ticks);
+    if (n == 0)
+      return false;
+
+    auto& stats = _idiom_stats[static_cast<size_t>(block.idiom)];
+    ++stats.runs;
+    stats.iterations += n;
+
+    return true;
+  }
+
+  CP&                _cp;
+  MM&                _mm;
+  BlockCache         _bc;
+  BlockCache::Block* _block             = nullptr;
+  size_t             _block_pos         = 0;
+  uint32_t           _block_map_version = 0;
+  idiom_stats_t      _idiom_stats       = {};
+};
+
+// The cached backend with hot rom blocks translated to x86-64.
+class JitBackend final : public CachedBackend
+{
+public:
+  JitBackend(CP& cp, MM& mm)
+    : CachedBackend(cp, mm)
+    , _jit(cp)
+  {
+    _jit.enable(true);
+  }
+
+  // false if there is no jit for this platform
+  bool available() const { return _jit.enabled(); }
+
+  Kind kind() const override { return Kind::Jit; }
+
+  void reset() override
+  {
+    _jit.reset();
+    CachedBackend::reset();
+  }
+
+  JitStats const* jit_stats() const override { return &_jit.stats(); }
+  void jit_verify(bool enable) override { _jit.verify(enable); }
+
+protected:
+  size_t _run_native(BlockCache::Block& block, uint32_t max_ticks) override
+  {
+    return _jit.run(block, max_ticks);
+  }
+
+private:
+  Jit<CP> _jit;
+};
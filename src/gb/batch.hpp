@@ -0,0 +1,133 @@
+#pragma once
+
+#include "types.h"
+#include "gb.hpp"
+#include "pool.hpp"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <string.h>
+
+// Many machines stepped together, for training agents on a game. All start
+// as clones of one machine and run a frame per step on a Pool, each with
+// its own buttons. After a step the screens of all of them are in one
+// buffer, machine after machine, and so are the observed memory bytes.
+class Batch
+{
+public:
+  static const size_t SCREEN_SIZE = sizeof(GR::screen_t);
+
+  // count clones of gb as it is now, which is also where reset() returns
+  // to; 0 threads is one per core
+  Batch(GB const& gb, size_t count, size_t threads = 0)
+    : _pool(threads)
+    , _screens(count * SCREEN_SIZE)
+  {
+    gb.save_state(_start);
+
+    _gbs.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+      _gbs.push_back(gb.clone());
+
+    for (size_t i = 0; i < count; ++i)
+      _copy_screen(i);
+  }
+
+  size_t size() const
+  {
+    return _gbs.size();
+  }
+
+  size_t threads() const
+  {
+    return _pool.threads();
+  }
+
+  GB& gb(size_t i)
+  {
+    return *_gbs[i];
+  }
+
+  // memory read into observations() after every step, in this order
+  void observe(std::vector<wide_reg_t> addresses)
+  {
+    _addresses = std::move(addresses);
+    _observations.assign(_gbs.size() * _addresses.size(), 0);
+    for (size_t i = 0; i < _gbs.size(); ++i)
+      _observe(i);
+  }
+
+  // one frame on every machine, with the Input::BUTTON_ bits of buttons[i]
+  // held on machine i
+  void step(reg_t const* buttons)
+  {
+    auto const start = std::chrono::steady_clock::now();
+
+    _pool.run(_gbs.size(), [this, buttons] (size_t i) {
+      _gbs[i]->buttons(buttons[i]);
+      _gbs[i]->run_frame();
+      _copy_screen(i);
+      _observe(i);
+    });
+
+    _spent  += std::chrono::steady_clock::now() - start;
+    _frames += _gbs.size();
+  }
+
+  // machine i back to the state the batch started with
+  void reset(size_t i)
+  {
+    _gbs[i]->load_state(_start);
+    _copy_screen(i);
+    _observe(i);
+  }
+
+  // size() * 144 * 160 shades, see GB::screen()
+  reg_t const* screens() const
+  {
+    return _screens.data();
+  }
+
+  // size() * observed addresses
+  reg_t const* observations() const
+  {
+    return _observations.data();
+  }
+
+  // of all machines together, over every step so far
+  uint64_t frames() const
+  {
+    return _frames;
+  }
+
+  double frames_per_second() const
+  {
+    auto const seconds = std::chrono::duration<double>(_spent).count();
+    return seconds > 0.0 ? _frames / seconds : 0.0;
+  }
+
+private:
+  void _copy_screen(size_t i)
+  {
+    memcpy(&_screens[i * SCREEN_SIZE], _gbs[i]->screen().data(), SCREEN_SIZE);
+  }
+
+  void _observe(size_t i)
+  {
+    auto* out = _observations.data() + i * _addresses.size();
+    for (auto const addr : _addresses)
+      *out++ = _gbs[i]->mem(addr);
+  }
+
+  Pool                             _pool;
+  std::vector<std::unique_ptr<GB>> _gbs;
+  std::vector<uint8_t>             _start;
+  std::vector<reg_t>               _screens;
+  std::vector<wide_reg_t>          _addresses;
+  std::vector<reg_t>               _observations;
+
+  uint64_t                            _frames = 0;
+  std::chrono::steady_clock::duration _spent{};
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Persists battery backed cartridge ram while the game runs. update() only
+// copies the banks written since the last call; a background thread writes
+// the whole ram to "<path>.tmp", syncs it and renames it over the save, so
+// a crash leaves either the previous or the new save behind. Saves are at
+// least WRITE_INTERVAL apart, updates in between are merged.
+class BatterySave
+{
+public:
+  static constexpr size_t BANK_SIZE = 0x2000;
+
+  static constexpr std::chrono::milliseconds WRITE_INTERVAL{ 1000 };
+
+  BatterySave(std::string path, mem_t const& ram)
+    : _path(std::move(path))
+    , _pending(ram)
+    , _thread([this] { _run(); })
+  {}
+
+  // writes whatever is still pending
+  ~BatterySave()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wake.notify_one();
+    _thread.join();
+  }
+
+  BatterySave(BatterySave const&) = delete;
+  BatterySave& operator=(BatterySave const&) = delete;
+
+  // called by the emulation with the banks it was told are dirty; holds
+  // the lock for a copy of those banks at most, never for disk io
+  void update(mem_t const& ram, uint32_t dirty_banks)
+  {
+    if (not dirty_banks)
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_pending.size() != ram.size())
+        _pending.resize(ram.size());
+
+      for (size_t bank = 0; bank < 32 and bank * BANK_SIZE < ram.size(); ++bank) {
+        if (not (dirty_banks & (1u << bank)))
+          continue;
+
+        auto const offset = bank * BANK_SIZE;
+        auto const size   = std::min(BANK_SIZE, ram.size() - offset);
+        memcpy(_pending.data() + offset, ram.data() + offset, size);
+      }
+
+      _dirty = true;
+    }
+    _wake.notify_one();
+  }
+
+  // number of completed writes, and failed ones
+  uint64_t writes() const { return _writes; }
+  uint64_t failures() const { return _failures; }
+
+private:
+  void _run()
+  {
+    mem_t image;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+      _wake.wait(lock, [this] { return _dirty or _stop; });
+      if (not _dirty)
+        return;
+
+      image  = _pending;
+      _dirty = false;
+
+      lock.unlock();
+      if (_write(image))
+        ++_writes;
+      else
+        ++_failures;
+      lock.lock();
+
+      _wake.wait_for(lock, WRITE_INTERVAL, [this] { return _stop; });
+    }
+  }
+
+  bool _write(mem_t const& image) const
+  {
+    auto const tmp_path = _path + ".tmp";
+
+    auto const fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return false;
+
+    auto const* bytes = image.data();
+    auto size = image.size();
+    while (size > 0) {
+      auto const n = ::write(fd, bytes, size);
+      if (n <= 0) {
+        close(fd);
+        return false;
+      }
+
+      bytes += n;
+      size  -= n;
+    }
+
+    if (fsync(fd) != 0 or close(fd) != 0)
+      return false;
+
+    return rename(tmp_path.c_str(), _path.c_str()) == 0;
+  }
+
+  std::string const       _path;
+  mem_t                   _pending;
+  bool                    _dirty = false;
+  bool                    _stop  = false;
+  std::atomic<uint64_t>   _writes   = { 0 };
+  std::atomic<uint64_t>   _failures = { 0 };
+  std::mutex              _mutex;
+  std::condition_variable _wake;
+  std::thread             _thread; // last, starts once the rest is set up
+};
@@ -0,0 +1,433 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+#include "idioms.hpp"
+#include "mm.hpp"
+#include "opcodes.hpp"
+#include "version.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class BlockCache
+{
+public:
+  struct Ins
+  {
+    wide_reg_t pc;
+    reg_t      op;
+    reg_t      b1;
+    reg_t      b2;
+    reg_t      len;
+  };
+
+  struct Block
+  {
+    uint16_t         bank;
+    uint32_t         first_page_version;
+    uint32_t         last_page_version;
+    std::vector<Ins> ins;
+    Idioms::Kind     idiom = Idioms::Kind::None;
+
+    // owned by the jit
+    uint32_t         heat         = 0;
+    void const*      native       = nullptr;
+    uint8_t          native_len   = 0;
+    uint16_t         native_ticks = 0;
+    bool             verified     = false;
+  };
+
+  struct Stats
+  {
+    uint64_t hits         = 0;
+    uint64_t misses       = 0;
+    uint64_t uncached     = 0;
+    uint64_t loaded       = 0;
+    uint64_t blocks       = 0;
+    uint64_t instructions = 0;
+
+    double hit_rate() const
+    {
+      auto const lookups = hits + misses;
+      return lookups ? static_cast<double>(hits) / lookups : 0.0;
+    }
+
+    double avg_block_length() const
+    {
+      return blocks ? static_cast<double>(instructions) / blocks : 0.0;
+    }
+  };
+
+  static const size_t MAX_BLOCK_LENGTH = 32;
+
+  // bump whenever the file layout or the decoding changes
+  static constexpr uint32_t FILE_VERSION = 2;
+
+  BlockCache(MM& mm)
+    : _mm(mm)
+  {}
+
+  void clear()
+  {
+    _blocks.clear();
+    _stats = Stats();
+  }
+
+  Stats const& stats() const
+  {
+    return _stats;
+  }
+
+  // returns the block starting at pc, decoding it on a miss;
+  // nullptr if the code at pc can not be cached
+  Block* lookup(wide_reg_t pc)
+  {
+    if (not _is_cacheable(pc)) {
+      ++_stats.uncached;
+      return nullptr;
+    }
+
+    auto const bank = _mm.bank(pc);
+    auto& block = _blocks[(static_cast<uint32_t>(bank) << 16) | pc];
+
+    if (not block.ins.empty() and is_valid(block)) {
+      ++_stats.hits;
+      return &block;
+    }
+
+    _build(block, bank, pc);
+
+    if (block.ins.empty()) {
+      ++_stats.uncached;
+      return nullptr;
+    }
+
+    ++_stats.misses;
+    ++_stats.blocks;
+    _stats.instructions += block.ins.size();
+
+    return &block;
+  }
+
+  // Persists the decoded rom blocks together with how often they were
+  // entered, so a later run of the same rom on the same core starts warm.
+  //
+  // header: "YGBC", version, core version, rom hash, block count
+  // block:  bank, pc, instruction count, heat, then op,b1,b2 per instruction
+  Error save(std::string const& path) const
+  {
+    std::vector<uint8_t> data;
+    _put(data, FILE_MAGIC, 4);
+    _put(data, FILE_VERSION);
+    _put(data, CORE_VERSION);
+    _put(data, _mm.rom_hash());
+
+    auto const count_offset = data.size();
+    _put(data, uint32_t(0));
+
+    uint32_t count = 0;
+    for (auto const& entry : _blocks) {
+      auto const& block = entry.second;
+      if (block.ins.empty() or block.bank == MM::BANK_RAM)
+        continue;
+
+      _put(data, block.bank);
+      _put(data, block.ins.front().pc);
+      _put(data, static_cast<uint8_t>(block.ins.size()));
+      _put(data, static_cast<uint8_t>(std::min<uint32_t>(block.heat, 0xFF)));
+      for (auto const& ins : block.ins) {
+        _put(data, ins.op);
+        _put(data, ins.b1);
+        _put(data, ins.b2);
+      }
+      ++count;
+    }
+    memcpy(data.data() + count_offset, &count, sizeof(count));
+
+    auto const tmp_path = path + ".tmp";
+    {
+      std::ofstream s(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+      s.write(reinterpret_cast<char const*>(data.data()), data.size());
+      if (not s)
+        return Error(Error::Code::FileNotAccessible);
+    }
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0)
+      return Error(Error::Code::FileNotAccessible);
+
+    return Error::NoError();
+  }
+
+  // Maps a file written by save() and inserts its blocks. Files from another
+  // rom, build or format are rejected as a whole.
+  Error load(std::string const& path, uint32_t max_heat)
+  {
+    auto const fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return Error(Error::Code::FileNotAccessible);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 or st.st_size == 0) {
+      close(fd);
+      return Error(Error::Code::FileNotAccessible);
+    }
+
+    auto const size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+      return Error(Error::Code::FileNotAccessible);
+
+    auto const error = _load(static_cast<uint8_t const*>(map), size, max_heat);
+    munmap(map, size);
+
+    return error;
+  }
+
+  // ram blocks are only valid as long as their pages were not written
+  bool is_valid(Block const& block) const
+  {
+    if (block.bank != MM::BANK_RAM)
+      return true;
+
+    return
+      _mm.page_version(block.ins.front().pc) == block.first_page_version and
+      _mm.page_version(_last_byte(block))    == block.last_page_version;
+  }
+
+  static Ins decode(MM const& mm, wide_reg_t pc)
+  {
+    return {
+      pc,
+      mm.read(pc),
+      mm.read(pc + 1),
+      mm.read(pc + 2),
+      Opcodes::length(mm.read(pc))
+    };
+  }
+
+  static bool ends_block(reg_t op)
+  {
+    switch (op) {
+    case 0x10: case 0x76:                                  // STOP, HALT
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+    case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: // JP
+    case 0xE9:                                             // JP (HL)
+    case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC: // CALL
+    case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: // RET
+    case 0xD9:                                             // RETI
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:            // RST
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+    case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4: // undefined
+    case 0xEB: case 0xEC: case 0xED: case 0xF4: case 0xFC:
+    case 0xFD:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+private:
+  static constexpr char const FILE_MAGIC[4] = { 'Y', 'G', 'B', 'C' };
+
+  template <typename T>
+  static void _put(std::vector<uint8_t>& data, T const& value)
+  {
+    _put(data, &value, sizeof(value));
+  }
+
+  static void _put(std::vector<uint8_t>& data, void const* src, size_t size)
+  {
+    auto const* bytes = static_cast<uint8_t const*>(src);
+    data.insert(data.end(), bytes, bytes + size);
+  }
+
+  template <typename T>
+  static bool _get(uint8_t const*& cur, uint8_t const* end, T& value)
+  {
+    if (static_cast<size_t>(end - cur) < sizeof(value))
+      return false;
+
+    memcpy(&value, cur, sizeof(value));
+    cur += sizeof(value);
+    return true;
+  }
+
+  Error _load(uint8_t const* cur, size_t size, uint32_t max_heat)
+  {
+    auto const* end = cur + size;
+
+    char     magic[4];
+    uint32_t version  = 0;
+    uint32_t core     = 0;
+    uint64_t rom_hash = 0;
+    uint32_t count    = 0;
+
+    if (not _get(cur, end, magic) or
+        not _get(cur, end, version) or
+        not _get(cur, end, core) or
+        not _get(cur, end, rom_hash) or
+        not _get(cur, end, count))
+      return Error(Error::Code::CacheOutdated);
+
+    if (memcmp(magic, FILE_MAGIC, 4) != 0 or
+        version  != FILE_VERSION or
+        core     != CORE_VERSION or
+        rom_hash != _mm.rom_hash())
+      return Error(Error::Code::CacheOutdated);
+
+    // bank, pc, length and heat and at least one instruction per block,
+    // checked before a broken count is allocated for
+    if (count > static_cast<size_t>(end - cur) / (6 + 3))
+      return Error(Error::Code::CacheOutdated);
+
+    std::vector<std::pair<uint32_t, Block>> blocks;
+    blocks.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      uint16_t   bank = 0;
+      wide_reg_t pc   = 0;
+      uint8_t    len  = 0;
+      uint8_t    heat = 0;
+
+      if (not _get(cur, end, bank) or
+          not _get(cur, end, pc) or
+          not _get(cur, end, len) or
+          not _get(cur, end, heat) or
+          len == 0 or len > MAX_BLOCK_LENGTH or
+          static_cast<size_t>(end - cur) < len * 3u)
+        return Error(Error::Code::CacheOutdated);
+
+      Block block;
+      block.bank = bank;
+      block.heat = std::min<uint32_t>(heat, max_heat);
+      block.first_page_version = 0;
+      block.last_page_version  = 0;
+
+      for (uint8_t n = 0; n < len; ++n) {
+        Ins ins = { pc, cur[0], cur[1], cur[2], Opcodes::length(cur[0]) };
+        block.ins.push_back(ins);
+        pc += ins.len;
+        cur += 3;
+      }
+      _tag_idiom(block);
+
+      auto const key = (static_cast<uint32_t>(bank) << 16) | block.ins.front().pc;
+      blocks.emplace_back(key, std::move(block));
+    }
+
+    for (auto& entry : blocks) {
+      auto& block = _blocks[entry.first];
+      if (not block.ins.empty())
+        continue;
+
+      ++_stats.loaded;
+      ++_stats.blocks;
+      _stats.instructions += entry.second.ins.size();
+      block = std::move(entry.second);
+    }
+
+    return Error::NoError();
+  }
+
+  // code must not leave the region it started in, otherwise a bank
+  // switch or boot rom unmap would silently change it
+  static wide_reg_t _region_end(wide_reg_t pc)
+  {
+    if (pc < 0x0100) return 0x0100;
+    if (pc < 0x4000) return 0x4000;
+    if (pc < 0x8000) return 0x8000;
+    if (pc < 0xA000) return 0xA000;
+    if (pc < 0xE000) return 0xE000;
+    return 0xFFFF;
+  }
+
+  bool _is_cacheable(wide_reg_t pc) const
+  {
+    // cart ram can be switched without a write, echo ram aliases wram and
+    // oam/io change underneath the cpu; leave those to the plain fetch
+    return
+      pc < 0xA000 or
+      (pc >= 0xC000 and pc < 0xE000) or
+      (pc >= 0xFF80 and pc < 0xFFFF);
+  }
+
+  void _build(Block& block, uint16_t bank, wide_reg_t pc)
+  {
+    auto const end = _region_end(pc);
+
+    block.bank       = bank;
+    block.idiom      = Idioms::Kind::None;
+    block.heat         = 0;
+    block.native       = nullptr;
+    block.native_len   = 0;
+    block.native_ticks = 0;
+    block.verified     = false;
+    block.ins.clear();
+
+    while (block.ins.size() < MAX_BLOCK_LENGTH) {
+      auto const ins = decode(_mm, pc);
+      if (static_cast<uint32_t>(pc) + ins.len > end)
+        break;
+
+      block.ins.push_back(ins);
+      pc += ins.len;
+
+      if (ends_block(ins.op))
+        break;
+    }
+
+    if (block.ins.empty())
+      return;
+
+    block.first_page_version = _mm.page_version(block.ins.front().pc);
+    block.last_page_version  = _mm.page_version(_last_byte(block));
+
+    _tag_idiom(block);
+  }
+
+  // operands of the last instruction may reach into the next page; blocks
+  // are shorter than a page, the first and the last byte cover them all
+  static wide_reg_t _last_byte(Block const& block)
+  {
+    auto const& last = block.ins.back();
+    return last.pc + last.len - 1;
+  }
+
+  // loops in ram could overwrite themselves, only rom code is tagged
+  static void _tag_idiom(Block& block)
+  {
+    if (block.bank == MM::BANK_RAM)
+      return;
+
+    reg_t  code[MAX_BLOCK_LENGTH * 3];
+    size_t size = 0;
+    for (auto const& ins : block.ins) {
+      reg_t const bytes[] = { ins.op, ins.b1, ins.b2 };
+      memcpy(code + size, bytes, ins.len);
+      size += ins.len;
+    }
+
+    block.idiom = Idioms::match(code, size);
+  }
+
+private:
+  MM& _mm;
+
+  std::unordered_map<uint32_t, Block> _blocks;
+  Stats                               _stats;
+};
@@ -2,8 +2,14 @@
 
 #include "types.h"
 #include "error.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+#include "rom_image.hpp"
+#include "state.hpp"
 #include "mbc.hpp"
 
+#include <algorithm>
+#include <array>
 #include <memory>
 
 class Cartridge
@@ -22,10 +28,38 @@ public:
     Unsupported,
   };
 
+  Cartridge() = default;
+
+  // shares the image and a patched rom, the ram is copied
+  Cartridge(Cartridge const& other)
+    : _image(other._image)
+    , _rom(other._rom)
+    , _patched(other._patched)
+    , _ram(other._ram)
+    , _dirty_ram_banks(other._dirty_ram_banks)
+    , _hash(other._hash)
+  {
+    if (other._mbc)
+      _mbc = other._mbc->clone(_rom, _ram);
+  }
+
+  Cartridge& operator=(Cartridge const&) = delete;
+
   Error load(std::vector<reg_t> const& data)
   {
-    _rom = data;
-    _mbc = _gen_mbc();
+    return load(RomImage::copy(data));
+  }
+
+  Error load(RomImage::handle_t image)
+  {
+    if (not image)
+      return Error(Error::Code::FileNotAccessible);
+
+    _image = std::move(image);
+    _rom   = { _image->data(), _image->size() };
+    _hash  = _image->hash();
+    _patched.reset();
+    _mbc   = _gen_mbc();
 
     if (_mbc.get() == nullptr)
       return Error(Error::Code::RomNotSupported);
@@ -40,15 +74,66 @@ public:
     return Error::NoError();
   }
 
-  mem_t ram() const
+  mem_t const& ram() const
   {
     return _ram;
   }
 
+  // GB::load_state checks the ram size before anything is restored
+  void save_state(StateWriter& state) const
+  {
+    state.put(_ram.data(), _ram.size());
+    _mbc->save_state(state);
+  }
+
+  // only banks that differ become dirty, run-ahead and rewind load states
+  // all the time without the battery save having to notice
+  void load_state(StateReader& state)
+  {
+    std::array<reg_t, 0x2000> bank;
+    for (size_t at = 0; at < _ram.size(); at += bank.size()) {
+      auto const size = std::min(bank.size(), _ram.size() - at);
+      state.get(bank.data(), size);
+      if (memcmp(&_ram[at], bank.data(), size) == 0)
+        continue;
+
+      memcpy(&_ram[at], bank.data(), size);
+      _dirty_ram_banks |= 1u << ((at / 0x2000) & 31);
+    }
+
+    _mbc->load_state(state);
+  }
+
+  // reads what load_state would, false if the banks it selects do not exist
+  bool check_state(StateReader& state) const
+  {
+    state.skip(_ram.size());
+    return _mbc->check_state(state);
+  }
+
+  // a byte of the whole ram, whichever bank is mapped; true if it changed
+  bool poke_ram(size_t offset, reg_t value)
+  {
+    if (offset >= _ram.size() or _ram[offset] == value)
+      return false;
+
+    _ram[offset] = value;
+    _dirty_ram_banks |= 1u << ((offset / 0x2000) & 31);
+    return true;
+  }
+
+  // ram banks written since the last call, bit n for the 8 KB at n * 0x2000
+  uint32_t take_dirty_ram_banks()
+  {
+    auto const dirty = _dirty_ram_banks;
+    _dirty_ram_banks = 0;
+    return dirty;
+  }
+
   void power_on()
   {
-    printf(
-      "CART: mbc type:%d rom banks:%d ram banks:%d\n",
+    Log::line(
+      "CART: mbc type:%d rom banks:%d ram banks:%d",
       read(0x0147),
       count_rom_banks(),
       count_ram_banks());
@@ -64,6 +149,67 @@ public:
   void write(wide_reg_t addr, reg_t value)
   {
     _mbc->write(addr, value);
+
+    if (addr >= 0xA000)
+      _dirty_ram_banks |= 1u << (_mbc->ram_bank() & 31);
+  }
+
+  int rom_bank() const
+  {
+    return _mbc->rom_bank();
+  }
+
+  // covers patches, code decoded from a patched rom is not reused without
+  uint64_t rom_hash() const
+  {
+    return _hash;
+  }
+
+  // the rom as loaded, without patches
+  uint64_t image_hash() const
+  {
+    return _image ? _image->hash() : 0;
+  }
+
+  // Patches addr in every rom bank that can be mapped there, like a Game
+  // Genie does on the bus, but once instead of on every read. With a
+  // compare value only banks holding it originally are patched. The shared
+  // image stays untouched, the first patch makes a copy, which clones share
+  // until one of them patches again. Returns the number of patched bytes.
+  size_t patch_rom(wide_reg_t addr, reg_t value, int compare = -1)
+  {
+    if (not _image)
+      return 0;
+
+    if (not _patched or _patched.use_count() > 1) {
+      _patched = std::make_shared<mem_t>(_rom.data, _rom.data + _rom.size);
+      _rom.data = _patched->data();
+    }
+
+    size_t patched = 0;
+
+    auto const first = static_cast<size_t>(addr);
+    auto const step  = addr < 0x4000 ? _rom.size : 0x4000;
+    for (auto offset = first; offset < _rom.size; offset += step) {
+      if (compare >= 0 and _image->data()[offset] != compare)
+        continue;
+
+      (*_patched)[offset] = value;
+      ++patched;
+    }
+
+    _hash = hash(_rom.data, _rom.size);
+    return patched;
+  }
+
+  void restore_rom()
+  {
+    if (not _patched)
+      return;
+
+    _patched.reset();
+    _rom.data = _image->data();
+    _hash     = _image->hash();
   }
 
   MbcType mbc_type() const {
@@ -137,7 +283,11 @@ private:
   }
 
 private:
-  std::unique_ptr<MBC> _mbc;
-  mem_t                _rom = mem_t();
-  mem_t                _ram = mem_t();
+  std::unique_ptr<MBC>   _mbc;
+  RomImage::handle_t     _image;
+  RomView                _rom;
+  std::shared_ptr<mem_t> _patched; // copy of the image once cheats patch it
+  mem_t                  _ram = mem_t();
+  uint32_t               _dirty_ram_banks = 0;
+  uint64_t               _hash = 0;
 };
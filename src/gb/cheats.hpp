@@ -0,0 +1,149 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+#include "mm.hpp"
+
+#include <string>
+#include <vector>
+
+#include <ctype.h>
+
+// Game Genie codes ("ABC-DEF" or "ABC-DEF-GHI") patch the rom image itself,
+// so reads never look for cheats. GameShark codes ("BBVVLLHH") are written
+// into ram once per frame; BB 00 or 01 writes whatever is mapped at HHLL,
+// 80 to 8F the cartridge ram bank in the low digit.
+class Cheats
+{
+public:
+  struct Code
+  {
+    enum class Kind { GameGenie, GameShark };
+
+    Kind        kind;
+    wide_reg_t  addr;
+    reg_t       value;
+    int         compare; // Game Genie only, -1 for none
+    int         bank;    // GameShark only, cartridge ram bank or -1 for the mapped memory
+    std::string text;
+  };
+
+  static Error parse(std::string const& text, Code& code)
+  {
+    std::string digits;
+    for (auto c : text) {
+      if (c == '-' or isspace(static_cast<unsigned char>(c)))
+        continue;
+      if (not isxdigit(static_cast<unsigned char>(c)))
+        return Error(Error::Code::CheatInvalid);
+      digits += c;
+    }
+
+    auto const hex = [&digits] (size_t pos, size_t len) {
+      return std::stoul(digits.substr(pos, len), nullptr, 16);
+    };
+
+    code.text = text;
+
+    if (digits.size() == 6 or digits.size() == 9) {
+      // AB value, FCDE address xor F000, GI original value rotated left
+      // by two and xor BA, H unused
+      code.kind    = Code::Kind::GameGenie;
+      code.value   = hex(0, 2);
+      code.addr    = ((hex(5, 1) ^ 0xF) << 12) | hex(2, 3);
+      code.compare = -1;
+      code.bank    = -1;
+
+      if (digits.size() == 9) {
+        reg_t const gi = (hex(6, 1) << 4) | hex(8, 1);
+        code.compare = static_cast<reg_t>((gi >> 2) | (gi << 6)) ^ 0xBA;
+      }
+
+      if (code.addr >= 0x8000)
+        return Error(Error::Code::CheatInvalid);
+
+      return Error::NoError();
+    }
+
+    if (digits.size() == 8) {
+      auto const type = hex(0, 2);
+
+      code.kind    = Code::Kind::GameShark;
+      code.value   = hex(2, 2);
+      code.addr    = hex(4, 2) | (hex(6, 2) << 8);
+      code.compare = -1;
+      code.bank    = type <= 0x01 ? -1 : type & 0x0F;
+
+      if (code.addr < 0x8000)
+        return Error(Error::Code::CheatInvalid);
+
+      // the work ram banks of the color model do not exist here
+      if (type > 0x01 and ((type & 0xF0) != 0x80 or code.addr < 0xA000 or code.addr >= 0xC000))
+        return Error(Error::Code::CheatInvalid);
+
+      return Error::NoError();
+    }
+
+    return Error(Error::Code::CheatInvalid);
+  }
+
+  // codes for a cartridge ram bank beyond ram_size bytes are rejected
+  Error add(std::string const& text, size_t ram_size)
+  {
+    Code code;
+    auto const error = parse(text, code);
+    if (error.is_set())
+      return error;
+
+    if (code.bank >= 0 and (code.bank + 1) * size_t(0x2000) > ram_size)
+      return Error(Error::Code::CheatInvalid);
+
+    _codes.push_back(code);
+    if (code.kind == Code::Kind::GameShark)
+      _pokes = true;
+
+    return Error::NoError();
+  }
+
+  void clear()
+  {
+    _codes.clear();
+    _pokes = false;
+  }
+
+  std::vector<Code> const& codes() const
+  {
+    return _codes;
+  }
+
+  // restores the rom and applies all Game Genie codes again
+  void patch(MM& mm) const
+  {
+    mm.restore_rom();
+
+    for (auto const& code : _codes) {
+      if (code.kind == Code::Kind::GameGenie)
+        mm.patch_rom(code.addr, code.value, code.compare);
+    }
+  }
+
+  void poke(MM& mm) const
+  {
+    if (not _pokes)
+      return;
+
+    for (auto const& code : _codes) {
+      if (code.kind != Code::Kind::GameShark)
+        continue;
+
+      if (code.bank < 0)
+        mm.write(code.addr, code.value, true);
+      else
+        mm.poke_ram(code.bank * 0x2000 + code.addr - 0xA000, code.value);
+    }
+  }
+
+private:
+  std::vector<Code> _codes;
+  bool              _pokes = false;
+};
@@ -2,52 +2,121 @@
 
 #include "types.h"
 #include "mm.hpp"
-
-#include <map>
-#include <map>
-#include <string>
+#include "backend.hpp"
+#include "block_cache.hpp"
+#include "jit.hpp"
+#include "opcode_stats.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+
+#include <array>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
 
 class CP
 {
-  struct Op
-  {
-    uint8_t               const code;
-    std::string           const desc;
-    std::function<void()> const fn;
-  };
+  friend class Jit<CP>;
+  friend class ReferenceBackend;
+  friend class CachedBackend;
+
+  using handler_t = void (CP::*)();
 
 public:
+  // ticks from now on that request none of the given interrupts (IE bits)
+  using quiet_ticks_t = std::function<uint32_t(reg_t)>;
+
   CP(MM& mm)
     : _mm(mm)
   {}
 
-  void power_on()
+  // the registers of other on mm, without a backend and statistics
+  CP(CP const& other, MM& mm)
+    : _mm(mm)
+    , _a(other._a), _b(other._b), _c(other._c), _d(other._d)
+    , _e(other._e), _f(other._f), _g(other._g), _h(other._h), _l(other._l)
+    , _sp(other._sp)
+    , _pc(other._pc)
+    , _ime(other._ime)
+    , _halted(other._halted)
+    , _cycles(other._cycles)
+    , _cycle(other._cycle)
+    , _ins(other._ins)
+  {}
+
+  // without the boot rom the registers are set the way it leaves them
+  void power_on(bool boot_rom = true)
   {
     _cycle  = 0;
     _cycles = 0;
     _halted = false;
     _ime    = false;
     // _flag   = 0;
-    _sp     = 0xFFFF;
-    _pc     = 0x0100;
+    _a = _b = _c = _d = _e = _f = _h = _l = 0;
+    _sp     = 0x0000;
+    _pc     = 0x0000;
+
+    if (not boot_rom) {
+      af(0x01B0);
+      bc(0x0013);
+      de(0x00D8);
+      hl(0x014D);
+      _sp = 0xFFFE;
+      _pc = 0x0100;
+    }
 
-    _mm.write(0xFF0F, 0x00); // interrupt flag
-    _mm.write(0xFFFF, 0xFF); // interrupt enable
+    if (_backend)
+      _backend->reset();
 
-    // check op code configuration
-    for (int i = 0; i < _ops.size(); ++i) {
-      if (_ops[i].code != i) {
-        printf("ERROR: opcode does not match: %02x\n", i);
-        exit(5);
-      }
-    }
+    _profiler.clear();
+    _opcode_stats.clear();
   }
 
+  // the backend keeps what it decoded, MM invalidates what changed
+  void save_state(StateWriter& state) const
+  {
+    state.put(_a); state.put(_b); state.put(_c); state.put(_d);
+    state.put(_e); state.put(_f); state.put(_h); state.put(_l);
+    state.put(_sp);
+    state.put(_pc);
+    state.put(_ime);
+    state.put(_halted);
+    state.put(_cycles);
+    state.put(_cycle);
+  }
+
+  void load_state(StateReader& state)
+  {
+    state.get(_a); state.get(_b); state.get(_c); state.get(_d);
+    state.get(_e); state.get(_f); state.get(_h); state.get(_l);
+    state.get(_sp);
+    state.get(_pc);
+    state.get(_ime);
+    state.get(_halted);
+    state.get(_cycles);
+    state.get(_cycle);
+  }
+
+  // where bulk execution learns when the rest of the machine requests
+  // interrupts; without it, bulk execution only runs while none can be
+  // taken
+  void quiet_ticks(quiet_ticks_t fn) { _quiet_ticks = std::move(fn); }
+
   wide_reg_t pc() const { return _pc; }
+  void pc(wide_reg_t value) { _pc = value; }
   wide_reg_t sp() const { return _sp; }
   void sp(wide_reg_t value) { _sp = value; }
 
+  bool ime() const { return _ime; }
+  bool halted() const { return _halted; }
+
+  // ticks left until the next instruction, 0 at an instruction boundary
+  uint32_t busy_cycles() const { return _cycles; }
+
+  // ticks since power on
+  uint64_t cycle() const { return _cycle; }
+
   bool zero_flag() const { return f() & (1 << 7); }
   void zero_flag(bool b) { _set_bit(7, b); }
 
@@ -88,28 +157,66 @@ public:
   void de(wide_reg_t value) { return _wide(d(), e(), value); }
   void hl(wide_reg_t value) { return _wide(h(), l(), value); }
 
-  reg_t op() const { return _mm.read(_pc); }
-  reg_t b1() const { return _mm.read(_pc + 1); }
-  reg_t b2() const { return _mm.read(_pc + 2); }
+  // bytes of the instruction currently executed
+  reg_t op() const { return _ins.op; }
+  reg_t b1() const { return _ins.b1; }
+  reg_t b2() const { return _ins.b2; }
   wide_reg_t nn() const { return (b2() << 8) | b1(); }
 
+  Backend& backend() { return *_backend; }
+  Backend const& backend() const { return *_backend; }
+
+  // registers and memory stay, only what the old backend decoded is lost
+  void backend(std::unique_ptr<Backend> backend) { _backend = std::move(backend); }
+
+  Trace& trace() { return _trace; }
+  Trace const& trace() const { return _trace; }
+
+  Profiler& profiler() { return _profiler; }
+  Profiler const& profiler() const { return _profiler; }
+
+  OpcodeStats& opcode_stats() { return _opcode_stats; }
+  OpcodeStats const& opcode_stats() const { return _opcode_stats; }
+
   bool tick()
   {
+    ++_cycle;
+
     if (_cycles > 0) {
       --_cycles;
       return false;
     }
 
+    auto& debugger = _mm.debugger();
+    if (debugger.stopped())
+      return false;
+
     _process_interrupt();
 
-    if (_halted)
+    if (_halted) {
+      if (_profiler.enabled())
+        _profiler.count_halted();
+      return false;
+    }
+
+    if (debugger.has_breakpoints() and debugger.breaks_at(_mm.bank(_pc), _pc))
       return false;
 
-#if DEBUG_CPU
-    dbg();
-#endif
+    if (_trace.enabled())
+      _record_trace();
+
+    // watchpoints only see the accesses of the instruction itself
+    auto const watching = debugger.watching();
+    if (watching)
+      debugger.executing(true);
 
-    _process_opcode();
+    if (_profiler.enabled() or _opcode_stats.enabled())
+      _instrumented_step();
+    else
+      _backend->step();
+
+    if (watching)
+      debugger.executing(false);
 
     return true;
   }
@@ -124,7 +231,7 @@ public:
       (half_carry_flag() ? 'H' : '_'),
       (carry_flag() ? 'C' : '_'),
       _mm.read(0xFF40),
-      _ops[ _mm.read(_pc)].desc.c_str());
+      Opcodes::name(_mm.read(_pc), _mm.read(_pc+1)));
   }
 
 private:
@@ -174,6 +281,39 @@ private:
     }
   }
 
+  void _record_trace()
+  {
+    auto& r = _trace.next();
+    r.cycle = _cycle;
+    r.pc    = _pc;
+    r.bank  = _mm.bank(_pc);
+    r.sp    = _sp;
+    r.af    = af();
+    r.bc    = bc();
+    r.de    = de();
+    r.hl    = hl();
+    r.op    = _mm.read(_pc);
+    r.b1    = _mm.read(_pc + 1);
+    r.b2    = _mm.read(_pc + 2);
+    r.ime   = _ime;
+    r.lcdc  = _mm.read(0xFF40);
+  }
+
+  // the bank is taken before the instruction can switch it
+  void _instrumented_step()
+  {
+    auto const pc   = _pc;
+    auto const bank = _mm.bank(pc);
+
+    _backend->step();
+
+    if (_profiler.enabled())
+      _profiler.count(bank, pc, _cycles + 1);
+
+    if (_opcode_stats.enabled())
+      _opcode_stats.count(_ins.op, _ins.b1, _cycles + 1);
+  }
+
   void _process_interrupt(wide_reg_t addr) {
     _ime = false;
     _push(_pc);
@@ -181,20 +321,152 @@ private:
     _halted = false; // FIXME where to put this?
   }
 
-  void _process_opcode()
+  // Ticks that a bulk loop or translated block may keep the cpu busy for.
+  // They only recognize interrupts once they are done, so while one can be
+  // taken they have to end before the next request of an enabled one, which
+  // is where the interpreter would take it. 0 when they must not run at
+  // all; they hide their instructions from the opcode statistics, the
+  // profiler and the debugger.
+  uint32_t _bulk_ticks() const
   {
-    auto const op_code = op();
+    if (_opcode_stats.enabled() or _profiler.enabled() or _mm.debugger().armed())
+      return 0;
+
+    auto const enabled = _mm.read(0xFFFF) & 0x1F;
+    if (not _ime or not enabled)
+      return BULK_UNBOUNDED;
+
+    if ((_mm.read(0xFF0F) & enabled) or not _quiet_ticks)
+      return 0;
 
-    if (op_code == 0xCB) {
-      auto fn = _pref.find(b1());
-      if (fn != _pref.end()) {
-        fn->second();
-        return;
+    return _quiet_ticks(enabled);
+  }
+
+  static bool _bulk_readable(wide_reg_t addr)
+  {
+    return addr < 0xFE00;
+  }
+
+  // vram is only touched in bulk while the lcd does not read it
+  bool _bulk_writable(wide_reg_t addr) const
+  {
+    if (addr < 0x8000 or addr >= 0xFE00)
+      return false;
+
+    return addr >= 0xA000 or not (_mm.read(0xFF40) & 0x80);
+  }
+
+  // Runs iterations of a tagged copy/fill loop without going through fetch
+  // and dispatch. Registers, flags, memory and cycles end up as if the
+  // instructions had been executed one by one. Interrupts are only checked
+  // after the chunk, so it takes at most max_ticks, see _bulk_ticks().
+  // Returns the number of iterations run.
+  uint32_t _run_idiom(BlockCache::Block const& block, uint32_t max_ticks)
+  {
+    uint32_t ticks = 0;
+    for (auto const& ins : block.ins)
+      ticks += Opcodes::cycles(ins.op, ins.b1) + 1;
+
+    auto const max = std::min(IDIOM_CHUNK, max_ticks / ticks);
+
+    uint32_t n = 0;
+    bool looping = true;
+
+    while (n < max and _idiom_step(block.idiom)) {
+      ++n;
+      if (zero_flag()) {
+        looping = false;
+        break;
       }
-      exit(1);
     }
 
-    _ops[op_code].fn();
+    if (n == 0)
+      return 0;
+
+    auto const& tail = block.ins.back();
+    if (not looping)
+      _pc = tail.pc + tail.len;
+
+    _cycles = n * ticks - 1;
+
+    return n;
+  }
+
+  // one iteration of the loop body up to the jump, false if it touches
+  // memory that has to go through the interpreter
+  bool _idiom_step(Idioms::Kind kind)
+  {
+    using Kind = Idioms::Kind;
+
+    switch (kind) {
+    case Kind::CopyBC:
+      if (not _bulk_readable(hl()) or not _bulk_writable(de()))
+        return false;
+      _ld8(_mm.read(hl()), a()); hl(hl() + 1);
+      _mm.write(de(), a());      de(de() + 1);
+      bc(bc() - 1);
+      _ld8(b(), a());
+      _or(c(), a());
+      return true;
+
+    case Kind::CopyDeBC:
+      if (not _bulk_readable(de()) or not _bulk_writable(hl()))
+        return false;
+      _ld8(_mm.read(de()), a());
+      _mm.write(hl(), a());      hl(hl() + 1);
+      de(de() + 1);
+      bc(bc() - 1);
+      _ld8(b(), a());
+      _or(c(), a());
+      return true;
+
+    case Kind::CopyB:
+    case Kind::CopyC:
+      if (not _bulk_readable(hl()) or not _bulk_writable(de()))
+        return false;
+      _ld8(_mm.read(hl()), a()); hl(hl() + 1);
+      _mm.write(de(), a());      de(de() + 1);
+      _dec(kind == Kind::CopyB ? b() : c());
+      return true;
+
+    case Kind::FillB:
+    case Kind::FillC:
+      if (not _bulk_writable(hl()))
+        return false;
+      _mm.write(hl(), a()); hl(hl() + 1);
+      _dec(kind == Kind::FillB ? b() : c());
+      return true;
+
+    case Kind::FillDownB:
+    case Kind::FillDownC:
+      if (not _bulk_writable(hl()))
+        return false;
+      _mm.write(hl(), a()); hl(hl() - 1);
+      _dec(kind == Kind::FillDownB ? b() : c());
+      return true;
+
+    case Kind::ClearDown:
+      if (not _bulk_writable(hl()))
+        return false;
+      _mm.write(hl(), a()); hl(hl() - 1);
+      _bit(h(), 7);
+      return true;
+
+    case Kind::None:
+      break;
+    }
+
+    return false;
+  }
+
+  void _execute()
+  {
+    auto const op_code = op();
+
+    if (op_code == 0xCB)
+      (this->*_cb_ops[b1()])();
+    else
+      (this->*_ops[op_code])();
   }
 
   wide_reg_t _wide(reg_t const& high, reg_t const& low) const
@@ -232,9 +504,21 @@ private:
     _mm.write(_sp, value);
   }
 
+  // data reads of instructions, these are the ones read watchpoints see
+  reg_t _read(wide_reg_t addr)
+  {
+    auto const value = _mm.read(addr);
+
+    auto& debugger = _mm.debugger();
+    if (debugger.watching() and (debugger.watched_page(addr) & Debugger::WATCH_READ))
+      debugger.access(Debugger::Hit::Kind::Read, addr, value);
+
+    return value;
+  }
+
   reg_t _pop_stack() // FIXME: dirty
   {
-    auto const v = _mm.read(_sp);
+    auto const v = _read(_sp);
     ++_sp;
     return v;
   }
@@ -533,1678 +817,414 @@ private:
   }
 
 private:
+  static constexpr uint32_t IDIOM_CHUNK    = 1024;
+  static constexpr uint32_t BULK_UNBOUNDED = std::numeric_limits<uint32_t>::max();
+
   MM&        _mm;
 
-  reg_t      _a;
-  reg_t      _b;
-  reg_t      _c;
-  reg_t      _d;
-  reg_t      _e;
-  reg_t      _f;
-  reg_t      _g;
-  reg_t      _h;
-  reg_t      _l;
+  reg_t      _a = 0;
+  reg_t      _b = 0;
+  reg_t      _c = 0;
+  reg_t      _d = 0;
+  reg_t      _e = 0;
+  reg_t      _f = 0;
+  reg_t      _g = 0;
+  reg_t      _h = 0;
+  reg_t      _l = 0;
   // reg_t      _flag;
-  wide_reg_t _sp;
-  wide_reg_t _pc;
-
-  bool       _ime;
-  bool       _halted;
-
-  uint8_t    _cycles; // FIXME: rename to busy_cycles
-  uint64_t   _cycle;
-
-  std::array<Op, 0x100> _ops = {{
-    {
-      0x00,
-      "NOP",
-      [this]() { _pc += 1; _cycles = 4; }
-    },
-    {
-      0x01,
-      "LD BC,nn",
-      [this]() { bc(nn()); _pc += 3; _cycles = 12; }
-    },
-    {
-      0x02,
-      "LD (BC),A",
-      [this]() { reg_t i; _ld8(a(), i); _mm.write(bc(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x03,
-      "INC BC",
-      [this]() { bc(bc() + 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x04,
-      "INC B",
-      [this]() { _inc(b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x05,
-      "DEC B",
-      [this]() { _dec(b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x06,
-      "LD B,n",
-      [this]() { _ld8(b1(), b()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x07,
-      "RLCA",
-      [this]() { _rlc(a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x08,
-      "LD (nn),SP",
-      [this]()
-      {
-        _mm.write(nn()    ,  sp() & 0x00FF      );
-        _mm.write(nn() + 1, (sp() & 0xFF00) >> 8);
-        _pc += 3;
-        _cycles = 20;
-      }
-    },
-    {
-      0x09,
-      "ADD HL,BC",
-      [this]() { hl(_add16(bc(), hl())); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x0A, "LD A,(BC)",
-      [this]() { _ld8(_mm.read(bc()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x0B,
-      "DEC BC",
-      [this]() { bc(bc() - 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x0C,
-      "INC C",
-      [this]() { _inc(c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x0D,
-      "DEC C",
-      [this]() { _dec(c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x0E,
-      "LD C,n",
-      [this]() { _ld8(b1(), c()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x0F,
-      "RRCA",
-      [this]() { _rrc(a()); _pc += 1; _cycles = 4; }
-    },
-
-    { 0x10,
-      "STOP",
-      [this]() { _halted = true; _pc += 2; _cycles = 4; }
-    },
-    {
-      0x11,
-      "LD DE,nn",
-      [this]() { de(nn()); _pc += 3; _cycles = 12; }
-    },
-    {
-      0x12,
-      "LD (DE),A",
-      [this]() { reg_t i; _ld8(a(), i); _mm.write(de(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x13,
-      "INC DE",
-      [this]() { de(de() + 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x14,
-      "INC D",
-      [this]() { _inc(d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x15,
-      "DEC D",
-      [this]() { _dec(d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x16,
-      "LD D,n",
-      [this]() { _ld8(b1(), d()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x17,
-      "RLA",
-      [this]() { _rl(a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x18,
-      "JR n",
-      [this]() { _pc += static_cast<int8_t>(b1()) + 2; _cycles = 8; }
-    },
-    {
-      0x19,
-      "ADD HL,DE",
-      [this]() { hl(_add16(de(), hl())); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x1A,
-      "LD A,(DE)",
-      [this]() { _ld8(_mm.read(de()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x1B,
-      "DEC DE",
-      [this]() { de(de() - 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x1C,
-      "INC E",
-      [this]() { _inc(e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x1D,
-      "DEC E",
-      [this]() { _dec(e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x1E,
-      "LD E,n",
-      [this]() { _ld8(b1(), e()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x1F,
-      "RRA",
-      [this]() { _rr(a()); _pc += 1; _cycles = 4; }
-    },
-
-    { 0x20,
-      "JR NZ,n",
-      [this]()
-	  {
-		int8_t r = b1();
-		if (zero_flag())
-          r = 0;
-		_pc += r + 2;
-		_cycles = 8;
-	  }
-    },
-    {
-      0x21,
-      "LD HL,nn",
-      [this]() { hl(nn()); _pc += 3; _cycles = 12; }
-    },
-    {
-      0x22,
-      "LD (HL+),A",
-      [this]() { reg_t i = 0; _ld8(a(), i); _mm.write(hl(), i); hl(hl()+1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x23,
-      "INC HL",
-      [this]() { hl(hl() + 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x24,
-      "INC H",
-      [this]() { _inc(h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x25,
-      "DEC H",
-      [this]() { _dec(h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x26,
-      "LD H,n",
-      [this]() { _ld8(b1(), h()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x27,
-      "DAA",
-      // [this]() { a() = ((a()/10%10)<<4)|((a()%10)&0xF); _pc += 1; _cycles = 4; }
-      [this]()
-      {
-        int va = a();
-        if (not substract_flag()) {
-          if (half_carry_flag() or (va & 0x0F) > 0x09)
-            va += 0x06;
-
-          if (carry_flag() or va > 0x9F) {
-            va += 0x60;
-          }
-        }
-        else {
-          if (half_carry_flag())
-            va = (va - 0x06) & 0xFF;
-
-          if (carry_flag())
-            va -= 0x60;
-        }
-
-        if ((va & 0x100) == 0x100) {
-          carry_flag(true);
-        }
-
-        half_carry_flag(false);
-        zero_flag((va & 0xFF) == 0);
-        a() = va & 0xFF;
-
-        _pc += 1; _cycles = 4;
-      }
-    },
-    {
-      0x28,
-      "JR Z,n",
-      [this]() { auto const d = (zero_flag())      ? static_cast<int8_t>(b1()) : 0; _pc += d + 2; _cycles = 8; }
-    },
-    {
-      0x29,
-      "ADD HL,HL",
-      [this]() { hl(_add16(hl(), hl())); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x2A,
-      "LD A,(HL+)",
-      [this]() { _ld8(_mm.read(hl()), a()); hl(hl()+1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x2B,
-      "DEC HL",
-      [this]() { hl(hl() - 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x2C,
-      "INC L",
-      [this]() { _inc(l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x2D,
-      "DEC L",
-      [this]() { _dec(l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x2E,
-      "LD L,n",
-      [this]() { _ld8(b1(), l()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x2F,
-      "CPL",
-      [this]() { a() = ~a(); substract_flag(true); half_carry_flag(true); _pc += 1; _cycles = 4; }
-    },
-
-    { 0x30,
-      "JR NC,n",
-      [this]() { auto const d = (not carry_flag()) ? static_cast<int8_t>(b1()) : 0; _pc += d + 2; _cycles = 8; }
-    },
-    {
-      0x31,
-      "LD SP,nn",
-      [this]() { sp(nn()); _pc += 3; _cycles = 12; }
-    },
-    {
-      0x32,
-      "LD (HL-),A",
-      [this]() { reg_t i = 0; _ld8(a(), i); _mm.write(hl(), i); hl(hl()-1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x33,
-      "INC SP",
-      [this]() { sp(sp() + 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x34,
-      "INC (HL)",
-      [this]() { reg_t i = _mm.read(hl()); _inc(i); _mm.write(hl(), i); _pc += 1; _cycles = 12; }
-    },
-    {
-      0x35,
-      "DEC (HL)",
-      [this]() { reg_t i = _mm.read(hl()); _dec(i); _mm.write(hl(), i); _pc += 1; _cycles = 12; }
-    },
-    {
-      0x36,
-      "LD (HL),n",
-      [this]() { reg_t i = 0; _ld8(b1(), i); _mm.write(hl(), i); _pc += 2; _cycles = 12; }
-    },
-    {
-      0x37,
-      "SCF",
-      [this]() { carry_flag(true); substract_flag(false); half_carry_flag(false); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x38,
-      "JR C,n",
-      [this]() { auto const d = (carry_flag())     ? static_cast<int8_t>(b1()) : 0; _pc += d + 2; _cycles = 8; }
-    },
-    {
-      0x39,
-      "ADD HL,SP",
-      [this]() { hl(_add16(sp(), hl())); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x3A,
-      "LD A,(HL-)",
-      [this]() { _ld8(_mm.read(hl()), a()); hl(hl()-1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x3B,
-      "DEC SP",
-      [this]() { sp(sp() - 1); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x3C,
-      "INC A",
-      [this]() { _inc(a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x3D,
-      "DEC A",
-      [this]() { _dec(a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x3E,
-      "LD A,n",
-      [this]() { _ld8(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0x3F,
-      "CCF",
-      [this]() { substract_flag(false); half_carry_flag(false); carry_flag(carry_flag()?false:true); _pc += 1; _cycles = 4; }
-    },
-
-    { 0x40,
-      "LD B,B",
-      [this]() { _ld8(b(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x41,
-      "LD B,C",
-      [this]() { _ld8(c(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x42,
-      "LD B,D",
-      [this]() { _ld8(d(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x43,
-      "LD B,E",
-      [this]() { _ld8(e(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x44,
-      "LD B,H",
-      [this]() { _ld8(h(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x45,
-      "LD B,L",
-      [this]() { _ld8(l(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x46,
-      "LD B,(HL)",
-      [this]() { _ld8(_mm.read(hl()), b()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x47,
-      "LD B,A",
-      [this]() { _ld8(a(), b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x48,
-      "LD C,B",
-      [this]() { _ld8(b(), c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x49,
-      "LD C,C",
-      [this]() { _ld8(c(), c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x4A,
-      "LD C,D",
-      [this]() { _ld8(d(), c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x4B,
-      "LD C,E",
-      [this]() { _ld8(e(), c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x4C,
-      "LD C,H",
-      [this]() { _ld8(h(), c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x4D,
-      "LD C,L",
-      [this]() { _ld8(l(), c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x4E,
-      "LD C,(HL)",
-      [this]() { _ld8(_mm.read(hl()), c()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x4F,
-      "LD C,A",
-      [this]() { _ld8(a(), c()); _pc += 1; _cycles = 4; }
-    },
-    { 0x50,
-      "LD D,B",
-      [this]() { _ld8(b(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x51,
-      "LD D,C",
-      [this]() { _ld8(c(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x52,
-      "LD D,D",
-      [this]() { _ld8(d(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x53,
-      "LD D,E",
-      [this]() { _ld8(e(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x54,
-      "LD D,H",
-      [this]() { _ld8(h(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x55,
-      "LD D,L",
-      [this]() { _ld8(l(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x56,
-      "LD D,(HL)",
-      [this]() { _ld8(_mm.read(hl()), d()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x57,
-      "LD D,A",
-      [this]() { _ld8(a(), d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x58,
-      "LD E,B",
-      [this]() { _ld8(b(), e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x59,
-      "LD E,C",
-      [this]() { _ld8(c(), e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x5A,
-      "LD E,D",
-      [this]() { _ld8(d(), e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x5B,
-      "LD E,E",
-      [this]() { _ld8(e(), e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x5C,
-      "LD E,H",
-      [this]() { _ld8(h(), e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x5D,
-      "LD E,L",
-      [this]() { _ld8(l(), e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x5E,
-      "LD E,(HL)",
-      [this]() { _ld8(_mm.read(hl()), e()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x5F,
-      "LD E,A",
-      [this]() { _ld8(a(), e()); _pc += 1; _cycles = 4; }
-    },
-
-    { 0x60,
-      "LD H,B",
-      [this]() { _ld8(b(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x61,
-      "LD H,C",
-      [this]() { _ld8(c(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x62,
-      "LD H,D",
-      [this]() { _ld8(d(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x63,
-      "LD H,E",
-      [this]() { _ld8(e(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x64,
-      "LD H,H",
-      [this]() { _ld8(h(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x65,
-      "LD H,l",
-      [this]() { _ld8(l(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x66,
-      "LD H,(HL)",
-      [this]() { _ld8(_mm.read(hl()), h()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x67,
-      "LD H,A",
-      [this]() { _ld8(a(), h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x68,
-      "LD L,B",
-      [this]() { _ld8(b(), l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x69,
-      "LD L,C",
-      [this]() { _ld8(c(), l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x6A,
-      "LD L,D",
-      [this]() { _ld8(d(), l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x6B,
-      "LD L,E",
-      [this]() { _ld8(e(), l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x6C,
-      "LD L,H",
-      [this]() { _ld8(h(), l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x6D,
-      "LD L,L",
-      [this]() { _ld8(l(), l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x6E,
-      "LD L,(HL)",
-      [this]() { _ld8(_mm.read(hl()), l()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x6F,
-      "LD L,A",
-      [this]() { _ld8(a(), l()); _pc += 1; _cycles = 4; }
-    },
-    { 0x70,
-      "LD (HL),B",
-      [this]() { reg_t i = 0; _ld8(b(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x71,
-      "LD (HL),C",
-      [this]() { reg_t i = 0; _ld8(c(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x72,
-      "LD (HL),D",
-      [this]() { reg_t i = 0; _ld8(d(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x73,
-      "LD (HL),E",
-      [this]() { reg_t i = 0; _ld8(e(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x74,
-      "LD (HL),H",
-      [this]() { reg_t i = 0; _ld8(h(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x75,
-      "LD (HL),L",
-      [this]() { reg_t i = 0; _ld8(l(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x76,
-      "HALT",
-      [this]() { _halted = true; _pc += 1; _cycles = 4; }
-    },
-    {
-      0x77,
-      "LD (HL),A",
-      [this]() { reg_t i = 0; _ld8(a(), i); _mm.write(hl(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x78,
-      "LD A,B",
-      [this]() { _ld8(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x79,
-      "LD A,C",
-      [this]() { _ld8(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x7A,
-      "LD A,D",
-      [this]() { _ld8(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x7B,
-      "LD A,E",
-      [this]() { _ld8(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x7C,
-      "LD A,H",
-      [this]() { _ld8(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x7D,
-      "LD A,L",
-      [this]() { _ld8(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x7E,
-      "LD A,(HL)",
-      [this]() { _ld8(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x7F,
-      "LD A,A",
-      [this]() { _ld8(a(), a()); _pc += 1; _cycles = 4; }
-    },
-
-    { 0x80,
-      "ADD A,B",
-      [this]() { _add8(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x81,
-      "ADD A,C",
-      [this]() { _add8(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x82,
-      "ADD A,D",
-      [this]() { _add8(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x83,
-      "ADD A,E",
-      [this]() { _add8(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x84,
-      "ADD A,H",
-      [this]() { _add8(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x85,
-      "ADD A,L",
-      [this]() { _add8(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x86,
-      "ADD A,(HL)",
-      [this]() { _add8(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x87,
-      "ADD A,A",
-      [this]() { _add8(a(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x88,
-      "ADC A,B",
-      [this]() { _adc8(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x89,
-      "ADC A,C",
-      [this]() { _adc8(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x8A,
-      "ADC A,D",
-      [this]() { _adc8(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x8B,
-      "ADC A,E",
-      [this]() { _adc8(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x8C,
-      "ADC A,H",
-      [this]() { _adc8(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x8D,
-      "ADC A,L",
-      [this]() { _adc8(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x8E,
-      "ADC A,(HL)",
-      [this]() { _adc8(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x8F,
-      "ADC A,A",
-      [this]() { _adc8(a(), a()); _pc += 1; _cycles = 4; }
-    },
-    { 0x90,
-      "SUB B",
-      [this]() { _sub8(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x91,
-      "SUB C",
-      [this]() { _sub8(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x92,
-      "SUB D",
-      [this]() { _sub8(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x93,
-      "SUB E",
-      [this]() { _sub8(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x94,
-      "SUB H",
-      [this]() { _sub8(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x95,
-      "SUB L",
-      [this]() { _sub8(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x96,
-      "SUB (HL)",
-      [this]() { _sub8(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x97,
-      "SUB A",
-      [this]() { _sub8(a(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x98,
-      "SBC A,B",
-      [this]() { _sbc8(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x99,
-      "SBC A,C",
-      [this]() { _sbc8(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x9A,
-      "SBC A,D",
-      [this]() { _sbc8(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x9B,
-      "SBC A,E",
-      [this]() { _sbc8(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x9C,
-      "SBC A,H",
-      [this]() { _sbc8(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x9D,
-      "SBC A,L",
-      [this]() { _sbc8(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0x9E,
-      "SBC A,(HL)",
-      [this]() { _sbc8(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0x9F,
-      "SBC A,A",
-      [this]() { _sbc8(a(), a()); _pc += 1; _cycles = 4; }
-    },
-    { 0xA0,
-      "AND B",
-      [this]() { _and(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA1,
-      "AND C",
-      [this]() { _and(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA2,
-      "AND D",
-      [this]() { _and(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA3,
-      "AND E",
-      [this]() { _and(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA4,
-      "AND H",
-      [this]() { _and(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA5,
-      "AND L",
-      [this]() { _and(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA6,
-      "AND (HL)",
-      [this]() { _and(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xA7,
-      "AND A",
-      [this]() { _and(a(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA8,
-      "XOR B",
-      [this]() { _xor(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xA9,
-      "XOR C",
-      [this]() { _xor(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xAA,
-      "XOR D",
-      [this]() { _xor(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xAB,
-      "XOR E",
-      [this]() { _xor(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xAC,
-      "XOR H",
-      [this]() { _xor(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xAD,
-      "XOR L",
-      [this]() { _xor(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xAE,
-      "XOR (HL)",
-      [this]() { _xor(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xAF,
-      "XOR A",
-      [this]() { _xor(a(), a()); _pc += 1; _cycles = 4; }
-    },
-
-    { 0xB0,
-      "OR B",
-      [this]() { _or(b(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB1,
-      "OR C",
-      [this]() { _or(c(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB2,
-      "OR D",
-      [this]() { _or(d(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB3,
-      "OR E",
-      [this]() { _or(e(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB4,
-      "OR H",
-      [this]() { _or(h(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB5,
-      "OR L",
-      [this]() { _or(l(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB6,
-      "OR (HL)",
-      [this]() { _or(_mm.read(hl()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xB7,
-      "OR A",
-      [this]() { _or(a(), a()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB8,
-      "CP B",
-      [this]() { _cp(b()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xB9,
-      "CP C",
-      [this]() { _cp(c()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xBA,
-      "CP D",
-      [this]() { _cp(d()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xBB,
-      "CP E",
-      [this]() { _cp(e()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xBC,
-      "CP H",
-      [this]() { _cp(h()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xBD,
-      "CP L",
-      [this]() { _cp(l()); _pc += 1; _cycles = 4; }
-    },
-    {
-      0xBE,
-      "CP (HL)",
-      [this]() { _cp(_mm.read(hl())); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xBF,
-      "CP A",
-      [this]() { _cp(a()); _pc += 1; _cycles = 4; }
-    },
-
-    { 0xC0,
-      "RET NZ",
-      [this]() { if (not zero_flag())  _pc = _pop(); else _pc += 1; _cycles = 12; }
-    },
-    {
-      0xC1,
-      "POP BC",
-      [this]() { bc(_pop()); _pc += 1; _cycles = 12; }
-    },
-    {
-      0xC2,
-      "JP NZ,nn",
-      [this]() { _pc = (not zero_flag()) ? nn() : _pc + 3; _cycles = 12; }
-    },
-    {
-      0xC3,
-      "JP nn",
-      [this]() { _pc = nn(); _cycles = 12; }
-    },
-    {
-      0xC4,
-      "CALL NZ,nn",
-      [this]() { if (not zero_flag())  _call(nn()); else _pc += 3; _cycles = 12; }
-    },
-    {
-      0xC5,
-      "PUSH BC",
-      [this]() { _push(bc()); _pc += 1; _cycles = 16; }
-    },
-    {
-      0xC6,
-      "ADD A,#",
-      [this]() { _add8(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xC7,
-      "RST 00H",
-      [this]() { _call(0x0000, 1); _cycles = 32; }
-    },
-    {
-      0xC8,
-      "RET Z",
-      [this]() { if (zero_flag())      _pc = _pop(); else _pc += 1; _cycles = 12; }
-    },
-    {
-      0xC9,
-      "RET",
-      [this]() { _pc = _pop(); _cycles = 8; }
-    },
-    {
-      0xCA,
-      "JP Z,nn",
-      [this]() { _pc = (zero_flag()) ? nn() : _pc + 3; _cycles = 12; }
-    },
-    {
-      0xCB,
-      "PREF",
-      []() {}
-    },
-    {
-      0xCC,
-      "CALL Z,nn",
-      [this]() { if (zero_flag())      _call(nn()); else _pc += 3; _cycles = 12; }
-    },
-    {
-      0xCD,
-      "CALL nn",
-      [this]() { _call(nn()); _cycles = 12; }
-    },
-    {
-      0xCE,
-      "ADC A,#",
-      [this]() { _adc8(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xCF,
-      "RST 08H",
-      [this]() { _call(0x0008, 1); _cycles = 32; }
-    },
-
-    { 0xD0,
-      "RET NC",
-      [this]() { if (not carry_flag()) _pc = _pop(); else _pc += 1; _cycles = 12; }
-    },
-    {
-      0xD1,
-      "POP DE",
-      [this]() { de(_pop()); _pc += 1; _cycles = 12; }
-    },
-    {
-      0xD2,
-      "JP NC,nn",
-      [this]() { _pc = (not carry_flag()) ? nn() : _pc + 3; _cycles = 12; }
-    },
-    {
-      0xD3,
-      "---",
-      []() {}
-    },
-    {
-      0xD4,
-      "CALL NC,nn",
-      [this]() { if (not carry_flag()) _call(nn()); else _pc += 3; _cycles = 12; }
-    },
-    {
-      0xD5,
-      "PUSH DE",
-      [this]() { _push(de()); _pc += 1; _cycles = 16; }
-    },
-    {
-      0xD6,
-      "SUB #",
-      [this]() { _sub8(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xD7,
-      "RST 10H",
-      [this]() { _call(0x0010, 1); _cycles = 32; }
-    },
-    {
-      0xD8,
-      "RET C",
-      [this]() { if (carry_flag())     _pc = _pop(); else _pc += 1; _cycles = 12; }
-    },
-    {
-      0xD9,
-      "RETI",
-      [this]() { _pc = _pop(); _ime = true; _cycles = 8; }
-    },
-    {
-      0xDA,
-      "JP C,nn",
-      [this]() { _pc = (carry_flag()) ? nn() : _pc + 3; _cycles = 12; }
-    },
-    {
-      0xDB,
-      "---",
-      []() {}
-    },
-    {
-      0xDC,
-      "CALL C,nn",
-      [this]() { if (carry_flag())     _call(nn()); else _pc += 3; _cycles = 12; }
-    },
-    {
-      0xDD,
-      "---",
-      []() {}
-    },
-    {
-      0xDE,
-      "SBC A,#",
-      [this]() { _sbc8(b1(), a()); _pc += 2; _cycles = 4; }
-    },
-    {
-      0xDF,
-      "RST 18H",
-      [this]() { _call(0x0018, 1); _cycles = 32; }
-    },
-
-    { 0xE0,
-      "LD (n),A",
-      [this]() { reg_t i = 0; _ld8(a(), i); _mm.write(0xFF00 + b1(), i); _pc += 2; _cycles = 12; }
-    },
-    {
-      0xE1,
-      "POP HL",
-      [this]() { hl(_pop()); _pc += 1; _cycles = 12; }
-    },
-    {
-      0xE2,
-      "LD (C),A",
-      [this]() { reg_t i = 0; _ld8(a(), i); _mm.write(0xFF00 + c(), i); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xE3,
-      "---",
-      []() {}
-    },
-    {
-      0xE4,
-      "---",
-      []() {}
-    },
-    {
-      0xE5,
-      "PUSH HL",
-      [this]() { _push(hl()); _pc += 1; _cycles = 16; }
-    },
-    {
-      0xE6,
-      "AND #",
-      [this]() { _and(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xE7,
-      "RST 20H",
-      [this]() { _call(0x0020, 1); _cycles = 32; }
-    },
-    {
-      0xE8,
-      "ADD SP,#",
-      [this]()
-      {
-        // int arg = b1();
-        // int src = sp();
-        // int result = src + arg;
-
-        // half_carry_flag(((sp() & 0x00FF) + (arg & 0x00FF)) > 0x00FF);
-        // carry_flag(result > 0xFFFF);
-
-        // FIXME SHAMELESS COPY
-        wide_reg_t reg = sp();
-        int8_t   value = b1();
-
-        int result = static_cast<int>(reg + value);
-
-        zero_flag(false);
-        substract_flag(false);
-        half_carry_flag(((reg ^ value ^ (result & 0xFFFF)) & 0x10) == 0x10);
-        carry_flag(((reg ^ value ^ (result & 0xFFFF)) & 0x100) == 0x100);
-
-        sp(static_cast<wide_reg_t>(result));
-
-        // sp(_add16(b1(), sp()));
-
-        // substract_flag(false);
-        // zero_flag(false);
-        _pc += 2;
-        _cycles = 16;
-      }
-    },
-    {
-      0xE9,
-      "JP (HL)",
-      [this]() { _pc = hl(); _cycles = 4; }
-    },
-    {
-      0xEA,
-      "LD (nn),A",
-      [this]() { reg_t i = 0; _ld8(a(), i); _mm.write(nn(), i); _pc += 3; _cycles = 8; }
-    },
-    {
-      0xEB,
-      "---",
-      []() {}
-    },
-    {
-      0xEC,
-      "---",
-      []() {}
-    },
-    {
-      0xED,
-      "---",
-      []() {}
-    },
-    {
-      0xEE,
-      "XOR #",
-      [this]() { _xor(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xEF,
-      "RST 28H",
-      [this]() { _call(0x0028, 1); _cycles = 32; }
-    },
-    { 0xF0,
-      "LD A,(n)",
-      [this]() { _ld8(_mm.read(0xFF00 + b1()), a()); _pc += 2; _cycles = 12; }
-    },
-    {
-      0xF1,
-      "POP AF",
-      [this]() { af(_pop()); _pc += 1; _cycles = 12; }
-    },
-    {
-      0xF2,
-      "LD A,(C)",
-      [this]() { _ld8(_mm.read(0xFF00 + c()), a()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xF3,
-      "DI",
-      [this]() { _ime = false; _pc += 1; _cycles = 4; }
-    },
-    {
-      0xF4,
-      "---",
-      []() {}
-    },
-    {
-      0xF5,
-      "PUSH AF",
-      [this]() { _push(af()); _pc += 1; _cycles = 16; }
-    },
-    {
-      0xF6,
-      "OR #",
-      [this]() { _or(b1(), a()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xF7,
-      "RST 30H",
-      [this]() { _call(0x0030, 1); _cycles = 32; }
-    },
-    {
-      0xF8,
-      "LD HL,SP+n",
-      [this]()
-      {
-        // FIXME SHAMELESS COPY
-        // _ld_hl_spn(b1());
-        wide_reg_t reg = sp();
-        int8_t   value = b1();
-
-        int result = static_cast<int>(reg + value);
-
-        zero_flag(false);
-        substract_flag(false);
-        half_carry_flag(((reg ^ value ^ (result & 0xFFFF)) & 0x10) == 0x10);
-        carry_flag(((reg ^ value ^ (result & 0xFFFF)) & 0x100) == 0x100);
-
-        hl(static_cast<wide_reg_t>(result));
-        _pc += 2;
-        _cycles = 12;
+  wide_reg_t _sp = 0;
+  wide_reg_t _pc = 0;
+
+  bool       _ime    = false;
+  bool       _halted = false;
+
+  uint32_t   _cycles = 0; // FIXME: rename to busy_cycles
+  uint64_t   _cycle  = 0; // ticks since power on
+
+  std::unique_ptr<Backend> _backend;
+  BlockCache::Ins          _ins = {};
+  quiet_ticks_t            _quiet_ticks;
+  Trace                    _trace;
+  Profiler                 _profiler;
+  OpcodeStats              _opcode_stats;
+
+  static const std::array<handler_t, 0x100> _ops;
+  static const std::array<handler_t, 0x100> _cb_ops;
+
+  // Instruction handlers, one instantiation per opcode. The operands are
+  // taken from the bit fields of the encoding (xx yyy zzz, with yyy split
+  // into pp q) and dispatched through static tables below the class, so
+  // constructing a cpu does not build anything. Names, lengths and cycles
+  // live in Opcodes.
+  //
+  // r:   B C D E H L (HL) A      rp:  BC DE HL SP      rp2: BC DE HL AF
+  // cc:  NZ Z NC C               alu: ADD ADC SUB SBC AND XOR OR CP
+
+  template <size_t... OP>
+  static constexpr std::array<handler_t, 0x100> _make_ops(std::index_sequence<OP...>)
+  {
+    return {{ &CP::_op<OP>... }};
+  }
+
+  template <size_t... OP>
+  static constexpr std::array<handler_t, 0x100> _make_cb_ops(std::index_sequence<OP...>)
+  {
+    return {{ &CP::_cb<OP>... }};
+  }
+
+  template <reg_t R>
+  reg_t& _r()
+  {
+    static_assert(R != 6, "(HL) is not a register");
+
+    if constexpr (R == 0) return b();
+    if constexpr (R == 1) return c();
+    if constexpr (R == 2) return d();
+    if constexpr (R == 3) return e();
+    if constexpr (R == 4) return h();
+    if constexpr (R == 5) return l();
+    if constexpr (R == 7) return a();
+  }
+
+  template <reg_t R>
+  reg_t _read_r()
+  {
+    if constexpr (R == 6)
+      return _read(hl());
+    else
+      return _r<R>();
+  }
+
+  template <reg_t R>
+  void _write_r(reg_t value)
+  {
+    if constexpr (R == 6)
+      _mm.write(hl(), value);
+    else
+      _r<R>() = value;
+  }
+
+  // applies fn to r, (HL) is read, modified and written back
+  template <reg_t R, typename Fn>
+  void _modify_r(Fn fn)
+  {
+    if constexpr (R == 6) {
+      reg_t i = _read(hl());
+      fn(i);
+      _mm.write(hl(), i);
+    }
+    else {
+      fn(_r<R>());
+    }
+  }
+
+  template <reg_t P, bool AF = false>
+  wide_reg_t _rp() const
+  {
+    if constexpr (P == 0) return bc();
+    if constexpr (P == 1) return de();
+    if constexpr (P == 2) return hl();
+    if constexpr (P == 3) return AF ? af() : sp();
+  }
+
+  template <reg_t P, bool AF = false>
+  void _rp(wide_reg_t value)
+  {
+    if constexpr (P == 0) bc(value);
+    if constexpr (P == 1) de(value);
+    if constexpr (P == 2) hl(value);
+    if constexpr (P == 3) { if constexpr (AF) af(value); else sp(value); }
+  }
+
+  template <reg_t CC>
+  bool _condition() const
+  {
+    if constexpr (CC == 0) return not zero_flag();
+    if constexpr (CC == 1) return zero_flag();
+    if constexpr (CC == 2) return not carry_flag();
+    if constexpr (CC == 3) return carry_flag();
+  }
+
+  template <reg_t ALU>
+  void _alu(reg_t n)
+  {
+    if constexpr (ALU == 0) _add8(n, a());
+    if constexpr (ALU == 1) _adc8(n, a());
+    if constexpr (ALU == 2) _sub8(n, a());
+    if constexpr (ALU == 3) _sbc8(n, a());
+    if constexpr (ALU == 4) _and(n, a());
+    if constexpr (ALU == 5) _xor(n, a());
+    if constexpr (ALU == 6) _or(n, a());
+    if constexpr (ALU == 7) _cp(n);
+  }
+
+  static constexpr bool _is_jump(reg_t op)
+  {
+    auto const x = op >> 6;
+    auto const y = (op >> 3) & 7;
+    auto const z = op & 7;
+
+    if (x == 0)
+      return z == 0 and y >= 3;                      // JR
+
+    if (x == 3)
+      return
+        (z == 0 and y < 4) or op == 0xC9 or op == 0xD9 or // RET, RETI
+        (z == 2 and y < 4) or op == 0xC3 or op == 0xE9 or // JP
+        (z == 4 and y < 4) or op == 0xCD or               // CALL
+        z == 7;                                           // RST
+
+    return false;
+  }
+
+  template <reg_t OP>
+  void _op()
+  {
+    constexpr auto info = Opcodes::info(OP);
+
+    if constexpr (info.cycles == 0) {
+      // undefined and the CB prefix, which is dispatched separately
+    }
+    else if constexpr (_is_jump(OP)) {
+      _jump<OP>();
+      _cycles = info.cycles;
+    }
+    else {
+      _operate<OP>();
+      _pc += info.length;
+      _cycles = info.cycles;
+    }
+  }
+
+  template <reg_t OP>
+  void _jump()
+  {
+    constexpr reg_t y = (OP >> 3) & 7;
+    constexpr reg_t z = OP & 7;
+
+    if constexpr (OP == 0x18)         // JR n
+      _pc += static_cast<int8_t>(b1()) + 2;
+    else if constexpr (OP < 0x40) {   // JR cc,n
+      auto const d = _condition<y - 4>() ? static_cast<int8_t>(b1()) : 0;
+      _pc += d + 2;
+    }
+    else if constexpr (OP == 0xC9)    // RET
+      _pc = _pop();
+    else if constexpr (OP == 0xD9) {  // RETI
+      _pc = _pop();
+      _ime = true;
+    }
+    else if constexpr (z == 0) {      // RET cc
+      if (_condition<y>()) _pc = _pop(); else _pc += 1;
+    }
+    else if constexpr (OP == 0xC3)    // JP nn
+      _pc = nn();
+    else if constexpr (OP == 0xE9)    // JP (HL)
+      _pc = hl();
+    else if constexpr (z == 2)        // JP cc,nn
+      _pc = _condition<y>() ? nn() : _pc + 3;
+    else if constexpr (OP == 0xCD)    // CALL nn
+      _call(nn());
+    else if constexpr (z == 4) {      // CALL cc,nn
+      if (_condition<y>()) _call(nn()); else _pc += 3;
+    }
+    else                              // RST
+      _call(y * 8, 1);
+  }
+
+  template <reg_t OP>
+  void _operate()
+  {
+    constexpr reg_t x = OP >> 6;
+    constexpr reg_t y = (OP >> 3) & 7;
+    constexpr reg_t z = OP & 7;
+    constexpr reg_t p = y >> 1;
+    constexpr reg_t q = y & 1;
+
+    if constexpr (OP == 0x00) {                  // NOP
+    }
+    else if constexpr (OP == 0x08) {             // LD (nn),SP
+      _mm.write(nn()    ,  sp() & 0x00FF      );
+      _mm.write(nn() + 1, (sp() & 0xFF00) >> 8);
+    }
+    else if constexpr (OP == 0x10 or OP == 0x76) // STOP, HALT
+      _halted = true;
+    else if constexpr (x == 0 and z == 1 and q == 0)
+      _rp<p>(nn());                              // LD rp,nn
+    else if constexpr (x == 0 and z == 1)
+      hl(_add16(_rp<p>(), hl()));                // ADD HL,rp
+    else if constexpr (x == 0 and z == 2)
+      _indirect<p, q>();                         // LD (rp),A / LD A,(rp)
+    else if constexpr (x == 0 and z == 3)
+      _rp<p>(q ? _rp<p>() - 1 : _rp<p>() + 1);   // INC rp, DEC rp
+    else if constexpr (x == 0 and z == 4)
+      _modify_r<y>([this](reg_t& r) { _inc(r); });
+    else if constexpr (x == 0 and z == 5)
+      _modify_r<y>([this](reg_t& r) { _dec(r); });
+    else if constexpr (x == 0 and z == 6)
+      _write_r<y>(b1());                         // LD r,n
+    else if constexpr (x == 0 and z == 7)
+      _accumulator<y>();
+    else if constexpr (x == 1)
+      _write_r<y>(_read_r<z>());                 // LD r,r
+    else if constexpr (x == 2)
+      _alu<y>(_read_r<z>());                     // alu A,r
+    else if constexpr (x == 3 and z == 6)
+      _alu<y>(b1());                             // alu A,n
+    else if constexpr (x == 3 and z == 1 and q == 0)
+      _rp<p, true>(_pop());                      // POP rp2
+    else if constexpr (x == 3 and z == 5 and q == 0)
+      _push(_rp<p, true>());                     // PUSH rp2
+    else if constexpr (OP == 0xE0)               // LD (n),A
+      _mm.write(0xFF00 + b1(), a());
+    else if constexpr (OP == 0xE2)               // LD (C),A
+      _mm.write(0xFF00 + c(), a());
+    else if constexpr (OP == 0xEA)               // LD (nn),A
+      _mm.write(nn(), a());
+    else if constexpr (OP == 0xF0)               // LD A,(n)
+      a() = _read(0xFF00 + b1());
+    else if constexpr (OP == 0xF2)               // LD A,(C)
+      a() = _read(0xFF00 + c());
+    else if constexpr (OP == 0xFA)               // LD A,(nn)
+      a() = _read(nn());
+    else if constexpr (OP == 0xE8)               // ADD SP,n
+      sp(_sp_plus_n());
+    else if constexpr (OP == 0xF8)               // LD HL,SP+n
+      hl(_sp_plus_n());
+    else if constexpr (OP == 0xF9)               // LD SP,HL
+      sp(hl());
+    else if constexpr (OP == 0xF3)               // DI
+      _ime = false;
+    else if constexpr (OP == 0xFB)               // EI
+      _ime = true;
+    else
+      static_assert(OP != OP, "opcode without implementation");
+  }
+
+  // LD (BC),A  LD (DE),A  LD (HL+),A  LD (HL-),A and the loads back into A
+  template <reg_t P, reg_t LOAD>
+  void _indirect()
+  {
+    constexpr auto addr = P < 2 ? P : 2;
+
+    if constexpr (LOAD)
+      a() = _read(_rp<addr>());
+    else
+      _mm.write(_rp<addr>(), a());
+
+    if constexpr (P == 2) hl(hl() + 1);
+    if constexpr (P == 3) hl(hl() - 1);
+  }
+
+  template <reg_t Y>
+  void _accumulator()
+  {
+    if constexpr (Y == 0) _rlc(a());                             // RLCA
+    if constexpr (Y == 1) _rrc(a());                             // RRCA
+    if constexpr (Y == 2) _rl(a());                              // RLA
+    if constexpr (Y == 3) _rr(a());                              // RRA
+    if constexpr (Y == 4) _daa();                                // DAA
+    if constexpr (Y == 5) {                                      // CPL
+      a() = ~a();
+      substract_flag(true);
+      half_carry_flag(true);
+    }
+    if constexpr (Y == 6) {                                      // SCF
+      carry_flag(true);
+      substract_flag(false);
+      half_carry_flag(false);
+    }
+    if constexpr (Y == 7) {                                      // CCF
+      substract_flag(false);
+      half_carry_flag(false);
+      carry_flag(not carry_flag());
+    }
+  }
+
+  // a() = ((a()/10%10)<<4)|((a()%10)&0xF);
+  void _daa()
+  {
+    int va = a();
+    if (not substract_flag()) {
+      if (half_carry_flag() or (va & 0x0F) > 0x09)
+        va += 0x06;
+
+      if (carry_flag() or va > 0x9F) {
+        va += 0x60;
       }
-    },
-    {
-      0xF9,
-      "LD SP,HL",
-      [this]() { sp(hl()); _pc += 1; _cycles = 8; }
-    },
-    {
-      0xFA,
-      "LD A,(nn)",
-      [this]() { _ld8(_mm.read(nn()), a()); _pc += 3; _cycles = 16; }
-    },
-    {
-      0xFB,
-      "EI",
-      [this]() { _ime = true; _pc += 1; _cycles = 4; }
-    },
-    {
-      0xFC,
-      "---",
-      []() {}
-    },
-    {
-      0xFD,
-      "---",
-      []() {}
-    },
-    {
-      0xFE,
-      "CP #",
-      [this]() { _cp(b1()); _pc += 2; _cycles = 8; }
-    },
-    {
-      0xFF,
-      "RST 38H",
-      [this]() { _call(0x0038, 1); _cycles = 32; }
     }
-  }};
-
-  std::map<reg_t, std::function<void()>> _pref {
-    { 0x00, /* RLC B   */ [this]() { _rlc(b(), true); _pc += 2; _cycles = 8; } },
-    { 0x01, /* RLC C   */ [this]() { _rlc(c(), true); _pc += 2; _cycles = 8; } },
-    { 0x02, /* RLC D   */ [this]() { _rlc(d(), true); _pc += 2; _cycles = 8; } },
-    { 0x03, /* RLC E   */ [this]() { _rlc(e(), true); _pc += 2; _cycles = 8; } },
-    { 0x04, /* RLC H   */ [this]() { _rlc(h(), true); _pc += 2; _cycles = 8; } },
-    { 0x05, /* RLC L   */ [this]() { _rlc(l(), true); _pc += 2; _cycles = 8; } },
-    { 0x06, /* RLC (HL)*/ [this]() { reg_t i = _mm.read(hl()); _rlc(i, true); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x07, /* RLC A   */ [this]() { _rlc(a(), true); _pc += 2; _cycles = 8; } },
-
-    { 0x08, /* RRC B   */ [this]() { _rrc(b(), true); _pc += 2; _cycles = 8; } },
-    { 0x09, /* RRC C   */ [this]() { _rrc(c(), true); _pc += 2; _cycles = 8; } },
-    { 0x0A, /* RRC D   */ [this]() { _rrc(d(), true); _pc += 2; _cycles = 8; } },
-    { 0x0B, /* RRC E   */ [this]() { _rrc(e(), true); _pc += 2; _cycles = 8; } },
-    { 0x0C, /* RRC H   */ [this]() { _rrc(h(), true); _pc += 2; _cycles = 8; } },
-    { 0x0D, /* RRC L   */ [this]() { _rrc(l(), true); _pc += 2; _cycles = 8; } },
-    { 0x0E, /* RRC (HL)*/ [this]() { reg_t i = _mm.read(hl()); _rrc(i, true); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x0F, /* RRC A   */ [this]() { _rrc(a(), true); _pc += 2; _cycles = 8; } },
-
-    { 0x10, /* RL B    */ [this]() { _rl(b(), true); _pc += 2; _cycles = 8; } },
-    { 0x11, /* RL C    */ [this]() { _rl(c(), true); _pc += 2; _cycles = 8; } },
-    { 0x12, /* RL D    */ [this]() { _rl(d(), true); _pc += 2; _cycles = 8; } },
-    { 0x13, /* RL E    */ [this]() { _rl(e(), true); _pc += 2; _cycles = 8; } },
-    { 0x14, /* RL H    */ [this]() { _rl(h(), true); _pc += 2; _cycles = 8; } },
-    { 0x15, /* RL L    */ [this]() { _rl(l(), true); _pc += 2; _cycles = 8; } },
-    { 0x16, /* RL (HL) */ [this]() { reg_t i = _mm.read(hl()); _rl(i, true); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x17, /* RL A    */ [this]() { _rl(a(), true); _pc += 2; _cycles = 8; } },
-
-    { 0x18, /* RR B    */ [this]() { _rr(b(), true); _pc += 2; _cycles = 8; } },
-    { 0x19, /* RR C    */ [this]() { _rr(c(), true); _pc += 2; _cycles = 8; } },
-    { 0x1A, /* RR D    */ [this]() { _rr(d(), true); _pc += 2; _cycles = 8; } },
-    { 0x1B, /* RR E    */ [this]() { _rr(e(), true); _pc += 2; _cycles = 8; } },
-    { 0x1C, /* RR H    */ [this]() { _rr(h(), true); _pc += 2; _cycles = 8; } },
-    { 0x1D, /* RR L    */ [this]() { _rr(l(), true); _pc += 2; _cycles = 8; } },
-    { 0x1E, /* RR (HL) */ [this]() { reg_t i = _mm.read(hl()); _rr(i, true); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x1F, /* RR A    */ [this]() { _rr(a(), true); _pc += 2; _cycles = 8; } },
-
-    { 0x20, /* SLA B    */ [this]() { _sla(b()); _pc += 2; _cycles = 8; } },
-    { 0x21, /* SLA C    */ [this]() { _sla(c()); _pc += 2; _cycles = 8; } },
-    { 0x22, /* SLA D    */ [this]() { _sla(d()); _pc += 2; _cycles = 8; } },
-    { 0x23, /* SLA E    */ [this]() { _sla(e()); _pc += 2; _cycles = 8; } },
-    { 0x24, /* SLA H    */ [this]() { _sla(h()); _pc += 2; _cycles = 8; } },
-    { 0x25, /* SLA L    */ [this]() { _sla(l()); _pc += 2; _cycles = 8; } },
-    { 0x26, /* SLA (HL) */ [this]() { reg_t i = _mm.read(hl()); _sla(i); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x27, /* SLA A    */ [this]() { _sla(a()); _pc += 2; _cycles = 8; } },
-
-    { 0x28, /* SRA B    */ [this]() { _sra(b()); _pc += 2; _cycles = 8; } },
-    { 0x29, /* SRA C    */ [this]() { _sra(c()); _pc += 2; _cycles = 8; } },
-    { 0x2A, /* SRA D    */ [this]() { _sra(d()); _pc += 2; _cycles = 8; } },
-    { 0x2B, /* SRA E    */ [this]() { _sra(e()); _pc += 2; _cycles = 8; } },
-    { 0x2C, /* SRA H    */ [this]() { _sra(h()); _pc += 2; _cycles = 8; } },
-    { 0x2D, /* SRA L    */ [this]() { _sra(l()); _pc += 2; _cycles = 8; } },
-    { 0x2E, /* SRA (HL) */ [this]() { reg_t i = _mm.read(hl()); _sra(i); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x2F, /* SRA A    */ [this]() { _sra(a()); _pc += 2; _cycles = 8; } },
-
-    { 0x30, /* SWAP B  */ [this]() { _swap(b()); _pc += 2; _cycles = 8; } },
-    { 0x31, /* SWAP C  */ [this]() { _swap(c()); _pc += 2; _cycles = 8; } },
-    { 0x32, /* SWAP D  */ [this]() { _swap(d()); _pc += 2; _cycles = 8; } },
-    { 0x33, /* SWAP E  */ [this]() { _swap(e()); _pc += 2; _cycles = 8; } },
-    { 0x34, /* SWAP H  */ [this]() { _swap(h()); _pc += 2; _cycles = 8; } },
-    { 0x35, /* SWAP L  */ [this]() { _swap(l()); _pc += 2; _cycles = 8; } },
-    { 0x36, /* SWAP(HL)*/ [this]() { reg_t i = _mm.read(hl()); _swap(i); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x37, /* SWAP A  */ [this]() { _swap(a()); _pc += 2; _cycles = 8; } },
-
-    { 0x38, /* SRL B    */ [this]() { _srl(b()); _pc += 2; _cycles = 8; } },
-    { 0x39, /* SRL C    */ [this]() { _srl(c()); _pc += 2; _cycles = 8; } },
-    { 0x3A, /* SRL D    */ [this]() { _srl(d()); _pc += 2; _cycles = 8; } },
-    { 0x3B, /* SRL E    */ [this]() { _srl(e()); _pc += 2; _cycles = 8; } },
-    { 0x3C, /* SRL H    */ [this]() { _srl(h()); _pc += 2; _cycles = 8; } },
-    { 0x3D, /* SRL L    */ [this]() { _srl(l()); _pc += 2; _cycles = 8; } },
-    { 0x3E, /* SRL (HL) */ [this]() { reg_t i = _mm.read(hl()); _srl(i); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x3F, /* SRL A    */ [this]() { _srl(a()); _pc += 2; _cycles = 8; } },
-
-    { 0x40, /* BIT 0,B    */ [this]() { _bit(b(), 0); _pc += 2; _cycles = 8; } },
-    { 0x41, /* BIT 0,C    */ [this]() { _bit(c(), 0); _pc += 2; _cycles = 8; } },
-    { 0x42, /* BIT 0,D    */ [this]() { _bit(d(), 0); _pc += 2; _cycles = 8; } },
-    { 0x43, /* BIT 0,E    */ [this]() { _bit(e(), 0); _pc += 2; _cycles = 8; } },
-    { 0x44, /* BIT 0,H    */ [this]() { _bit(h(), 0); _pc += 2; _cycles = 8; } },
-    { 0x45, /* BIT 0,L    */ [this]() { _bit(l(), 0); _pc += 2; _cycles = 8; } },
-    { 0x46, /* BIT 0,(HL) */ [this]() { reg_t i = _mm.read(hl()); _bit(i, 0); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x47, /* BIT 0,A    */ [this]() { _bit(a(), 0); _pc += 2; _cycles = 8; } },
-
-    { 0x48, /* BIT 1,B    */ [this]() { _bit(b(), 1); _pc += 2; _cycles = 8; } },
-    { 0x49, /* BIT 1,C    */ [this]() { _bit(c(), 1); _pc += 2; _cycles = 8; } },
-    { 0x4A, /* BIT 1,D    */ [this]() { _bit(d(), 1); _pc += 2; _cycles = 8; } },
-    { 0x4B, /* BIT 1,E    */ [this]() { _bit(e(), 1); _pc += 2; _cycles = 8; } },
-    { 0x4C, /* BIT 1,H    */ [this]() { _bit(h(), 1); _pc += 2; _cycles = 8; } },
-    { 0x4D, /* BIT 1,L    */ [this]() { _bit(l(), 1); _pc += 2; _cycles = 8; } },
-    { 0x4E, /* BIT 1,(HL) */ [this]() { reg_t i = _mm.read(hl()); _bit(i, 1); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x4F, /* BIT 1,A    */ [this]() { _bit(a(), 1); _pc += 2; _cycles = 8; } },
-
-    { 0x50, /* BIT 2,B    */ [this]() { _bit(b(), 2); _pc += 2; _cycles = 8; } },
-    { 0x51, /* BIT 2,C    */ [this]() { _bit(c(), 2); _pc += 2; _cycles = 8; } },
-    { 0x52, /* BIT 2,D    */ [this]() { _bit(d(), 2); _pc += 2; _cycles = 8; } },
-    { 0x53, /* BIT 2,E    */ [this]() { _bit(e(), 2); _pc += 2; _cycles = 8; } },
-    { 0x54, /* BIT 2,H    */ [this]() { _bit(h(), 2); _pc += 2; _cycles = 8; } },
-    { 0x55, /* BIT 2,L    */ [this]() { _bit(l(), 2); _pc += 2; _cycles = 8; } },
-    { 0x56, /* BIT 2,(HL) */ [this]() { reg_t i = _mm.read(hl()); _bit(i, 2); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x57, /* BIT 2,A    */ [this]() { _bit(a(), 2); _pc += 2; _cycles = 8; } },
-
-    { 0x58, /* BIT 3,B    */ [this]() { _bit(b(), 3); _pc += 2; _cycles = 8; } },
-    { 0x59, /* BIT 3,C    */ [this]() { _bit(c(), 3); _pc += 2; _cycles = 8; } },
-    { 0x5A, /* BIT 3,D    */ [this]() { _bit(d(), 3); _pc += 2; _cycles = 8; } },
-    { 0x5B, /* BIT 3,E    */ [this]() { _bit(e(), 3); _pc += 2; _cycles = 8; } },
-    { 0x5C, /* BIT 3,H    */ [this]() { _bit(h(), 3); _pc += 2; _cycles = 8; } },
-    { 0x5D, /* BIT 3,L    */ [this]() { _bit(l(), 3); _pc += 2; _cycles = 8; } },
-    { 0x5E, /* BIT 3,(HL) */ [this]() { _bit(_mm.read(hl()), 3); _pc += 2; _cycles = 16; } },
-    { 0x5F, /* BIT 3,A    */ [this]() { _bit(a(), 3); _pc += 2; _cycles = 8; } },
-
-    { 0x60, /* BIT 4,B    */ [this]() { _bit(b(), 4); _pc += 2; _cycles = 8; } },
-    { 0x61, /* BIT 4,C    */ [this]() { _bit(c(), 4); _pc += 2; _cycles = 8; } },
-    { 0x62, /* BIT 4,D    */ [this]() { _bit(d(), 4); _pc += 2; _cycles = 8; } },
-    { 0x63, /* BIT 4,E    */ [this]() { _bit(e(), 4); _pc += 2; _cycles = 8; } },
-    { 0x64, /* BIT 4,H    */ [this]() { _bit(h(), 4); _pc += 2; _cycles = 8; } },
-    { 0x65, /* BIT 4,L    */ [this]() { _bit(l(), 4); _pc += 2; _cycles = 8; } },
-    { 0x66, /* BIT 4,(HL) */ [this]() { _bit(_mm.read(hl()), 4); _pc += 2; _cycles = 16; } },
-    { 0x67, /* BIT 4,A    */ [this]() { _bit(a(), 4); _pc += 2; _cycles = 8; } },
-
-    { 0x68, /* BIT 5,B    */ [this]() { _bit(b(), 5); _pc += 2; _cycles = 8; } },
-    { 0x69, /* BIT 5,C    */ [this]() { _bit(c(), 5); _pc += 2; _cycles = 8; } },
-    { 0x6A, /* BIT 5,D    */ [this]() { _bit(d(), 5); _pc += 2; _cycles = 8; } },
-    { 0x6B, /* BIT 5,E    */ [this]() { _bit(e(), 5); _pc += 2; _cycles = 8; } },
-    { 0x6C, /* BIT 5,H    */ [this]() { _bit(h(), 5); _pc += 2; _cycles = 8; } },
-    { 0x6D, /* BIT 5,L    */ [this]() { _bit(l(), 5); _pc += 2; _cycles = 8; } },
-    { 0x6E, /* BIT 5,(HL) */ [this]() { _bit(_mm.read(hl()), 5); _pc += 2; _cycles = 16; } },
-    { 0x6F, /* BIT 5,A    */ [this]() { _bit(a(), 5); _pc += 2; _cycles = 8; } },
-
-    { 0x70, /* BIT 6,B    */ [this]() { _bit(b(), 6); _pc += 2; _cycles = 8; } },
-    { 0x71, /* BIT 6,C    */ [this]() { _bit(c(), 6); _pc += 2; _cycles = 8; } },
-    { 0x72, /* BIT 6,D    */ [this]() { _bit(d(), 6); _pc += 2; _cycles = 8; } },
-    { 0x73, /* BIT 6,E    */ [this]() { _bit(e(), 6); _pc += 2; _cycles = 8; } },
-    { 0x74, /* BIT 6,H    */ [this]() { _bit(h(), 6); _pc += 2; _cycles = 8; } },
-    { 0x75, /* BIT 6,L    */ [this]() { _bit(l(), 6); _pc += 2; _cycles = 8; } },
-    { 0x76, /* BIT 6,(HL) */ [this]() { _bit(_mm.read(hl()), 6); _pc += 2; _cycles = 16; } },
-    { 0x77, /* BIT 6,A    */ [this]() { _bit(a(), 6); _pc += 2; _cycles = 8; } },
-
-    { 0x78, /* BIT 7,B    */ [this]() { _bit(b(), 7); _pc += 2; _cycles = 8; } },
-    { 0x79, /* BIT 7,C    */ [this]() { _bit(c(), 7); _pc += 2; _cycles = 8; } },
-    { 0x7A, /* BIT 7,D    */ [this]() { _bit(d(), 7); _pc += 2; _cycles = 8; } },
-    { 0x7B, /* BIT 7,E    */ [this]() { _bit(e(), 7); _pc += 2; _cycles = 8; } },
-    { 0x7C, /* BIT 7,H    */ [this]() { _bit(h(), 7); _pc += 2; _cycles = 8; } },
-    { 0x7D, /* BIT 7,L    */ [this]() { _bit(l(), 7); _pc += 2; _cycles = 8; } },
-    { 0x7E, /* BIT 7,(HL) */ [this]() { _bit(_mm.read(hl()), 7); _pc += 2; _cycles = 16; } },
-    { 0x7F, /* BIT 7,A    */ [this]() { _bit(a(), 7); _pc += 2; _cycles = 8; } },
-
-    { 0x80, /* RES 0,B    */ [this]() { _res(b(), 0); _pc += 2; _cycles = 8; } },
-    { 0x81, /* RES 0,C    */ [this]() { _res(c(), 0); _pc += 2; _cycles = 8; } },
-    { 0x82, /* RES 0,D    */ [this]() { _res(d(), 0); _pc += 2; _cycles = 8; } },
-    { 0x83, /* RES 0,E    */ [this]() { _res(e(), 0); _pc += 2; _cycles = 8; } },
-    { 0x84, /* RES 0,H    */ [this]() { _res(h(), 0); _pc += 2; _cycles = 8; } },
-    { 0x85, /* RES 0,L    */ [this]() { _res(l(), 0); _pc += 2; _cycles = 8; } },
-    { 0x86, /* RES 0,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 0); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x87, /* RES 0,A    */ [this]() { _res(a(), 0); _pc += 2; _cycles = 8; } },
-
-    { 0x88, /* RES 1,B    */ [this]() { _res(b(), 1); _pc += 2; _cycles = 8; } },
-    { 0x89, /* RES 1,C    */ [this]() { _res(c(), 1); _pc += 2; _cycles = 8; } },
-    { 0x8A, /* RES 1,D    */ [this]() { _res(d(), 1); _pc += 2; _cycles = 8; } },
-    { 0x8B, /* RES 1,E    */ [this]() { _res(e(), 1); _pc += 2; _cycles = 8; } },
-    { 0x8C, /* RES 1,H    */ [this]() { _res(h(), 1); _pc += 2; _cycles = 8; } },
-    { 0x8D, /* RES 1,L    */ [this]() { _res(l(), 1); _pc += 2; _cycles = 8; } },
-    { 0x8E, /* RES 1,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 1); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x8F, /* RES 1,A    */ [this]() { _res(a(), 1); _pc += 2; _cycles = 8; } },
-
-    { 0x90, /* RES 2,B    */ [this]() { _res(b(), 2); _pc += 2; _cycles = 8; } },
-    { 0x91, /* RES 2,C    */ [this]() { _res(c(), 2); _pc += 2; _cycles = 8; } },
-    { 0x92, /* RES 2,D    */ [this]() { _res(d(), 2); _pc += 2; _cycles = 8; } },
-    { 0x93, /* RES 2,E    */ [this]() { _res(e(), 2); _pc += 2; _cycles = 8; } },
-    { 0x94, /* RES 2,H    */ [this]() { _res(h(), 2); _pc += 2; _cycles = 8; } },
-    { 0x95, /* RES 2,L    */ [this]() { _res(l(), 2); _pc += 2; _cycles = 8; } },
-    { 0x96, /* RES 2,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 2); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x97, /* RES 2,A    */ [this]() { _res(a(), 2); _pc += 2; _cycles = 8; } },
-
-    { 0x98, /* RES 3,B    */ [this]() { _res(b(), 3); _pc += 2; _cycles = 8; } },
-    { 0x99, /* RES 3,C    */ [this]() { _res(c(), 3); _pc += 2; _cycles = 8; } },
-    { 0x9A, /* RES 3,D    */ [this]() { _res(d(), 3); _pc += 2; _cycles = 8; } },
-    { 0x9B, /* RES 3,E    */ [this]() { _res(e(), 3); _pc += 2; _cycles = 8; } },
-    { 0x9C, /* RES 3,H    */ [this]() { _res(h(), 3); _pc += 2; _cycles = 8; } },
-    { 0x9D, /* RES 3,L    */ [this]() { _res(l(), 3); _pc += 2; _cycles = 8; } },
-    { 0x9E, /* RES 3,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 3); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0x9F, /* RES 3,A    */ [this]() { _res(a(), 3); _pc += 2; _cycles = 8; } },
-
-    { 0xA0, /* RES 4,B    */ [this]() { _res(b(), 4); _pc += 2; _cycles = 8; } },
-    { 0xA1, /* RES 4,C    */ [this]() { _res(c(), 4); _pc += 2; _cycles = 8; } },
-    { 0xA2, /* RES 4,D    */ [this]() { _res(d(), 4); _pc += 2; _cycles = 8; } },
-    { 0xA3, /* RES 4,E    */ [this]() { _res(e(), 4); _pc += 2; _cycles = 8; } },
-    { 0xA4, /* RES 4,H    */ [this]() { _res(h(), 4); _pc += 2; _cycles = 8; } },
-    { 0xA5, /* RES 4,L    */ [this]() { _res(l(), 4); _pc += 2; _cycles = 8; } },
-    { 0xA6, /* RES 4,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 4); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xA7, /* RES 4,A    */ [this]() { _res(a(), 4); _pc += 2; _cycles = 8; } },
-
-    { 0xA8, /* RES 5,B    */ [this]() { _res(b(), 5); _pc += 2; _cycles = 8; } },
-    { 0xA9, /* RES 5,C    */ [this]() { _res(c(), 5); _pc += 2; _cycles = 8; } },
-    { 0xAA, /* RES 5,D    */ [this]() { _res(d(), 5); _pc += 2; _cycles = 8; } },
-    { 0xAB, /* RES 5,E    */ [this]() { _res(e(), 5); _pc += 2; _cycles = 8; } },
-    { 0xAC, /* RES 5,H    */ [this]() { _res(h(), 5); _pc += 2; _cycles = 8; } },
-    { 0xAD, /* RES 5,L    */ [this]() { _res(l(), 5); _pc += 2; _cycles = 8; } },
-    { 0xAE, /* RES 5,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 5); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xAF, /* RES 5,A    */ [this]() { _res(a(), 5); _pc += 2; _cycles = 8; } },
-
-    { 0xB0, /* RES 6,B    */ [this]() { _res(b(), 6); _pc += 2; _cycles = 8; } },
-    { 0xB1, /* RES 6,C    */ [this]() { _res(c(), 6); _pc += 2; _cycles = 8; } },
-    { 0xB2, /* RES 6,D    */ [this]() { _res(d(), 6); _pc += 2; _cycles = 8; } },
-    { 0xB3, /* RES 6,E    */ [this]() { _res(e(), 6); _pc += 2; _cycles = 8; } },
-    { 0xB4, /* RES 6,H    */ [this]() { _res(h(), 6); _pc += 2; _cycles = 8; } },
-    { 0xB5, /* RES 6,L    */ [this]() { _res(l(), 6); _pc += 2; _cycles = 8; } },
-    { 0xB6, /* RES 6,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 6); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xB7, /* RES 6,A    */ [this]() { _res(a(), 6); _pc += 2; _cycles = 8; } },
-
-    { 0xB8, /* RES 7,B    */ [this]() { _res(b(), 7); _pc += 2; _cycles = 8; } },
-    { 0xB9, /* RES 7,C    */ [this]() { _res(c(), 7); _pc += 2; _cycles = 8; } },
-    { 0xBA, /* RES 7,D    */ [this]() { _res(d(), 7); _pc += 2; _cycles = 8; } },
-    { 0xBB, /* RES 7,E    */ [this]() { _res(e(), 7); _pc += 2; _cycles = 8; } },
-    { 0xBC, /* RES 7,H    */ [this]() { _res(h(), 7); _pc += 2; _cycles = 8; } },
-    { 0xBD, /* RES 7,L    */ [this]() { _res(l(), 7); _pc += 2; _cycles = 8; } },
-    { 0xBE, /* RES 7,(HL) */ [this]() { reg_t i = _mm.read(hl()); _res(i, 7); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xBF, /* RES 7,A    */ [this]() { _res(a(), 7); _pc += 2; _cycles = 8; } },
-
-    { 0xC0, /* SET 0,B    */ [this]() { _set(b(), 0); _pc += 2; _cycles = 8; } },
-    { 0xC1, /* SET 0,C    */ [this]() { _set(c(), 0); _pc += 2; _cycles = 8; } },
-    { 0xC2, /* SET 0,D    */ [this]() { _set(d(), 0); _pc += 2; _cycles = 8; } },
-    { 0xC3, /* SET 0,E    */ [this]() { _set(e(), 0); _pc += 2; _cycles = 8; } },
-    { 0xC4, /* SET 0,H    */ [this]() { _set(h(), 0); _pc += 2; _cycles = 8; } },
-    { 0xC5, /* SET 0,L    */ [this]() { _set(l(), 0); _pc += 2; _cycles = 8; } },
-    { 0xC6, /* SET 0,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 0); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xC7, /* SET 0,A    */ [this]() { _set(a(), 0); _pc += 2; _cycles = 8; } },
-
-    { 0xC8, /* SET 1,B    */ [this]() { _set(b(), 1); _pc += 2; _cycles = 8; } },
-    { 0xC9, /* SET 1,C    */ [this]() { _set(c(), 1); _pc += 2; _cycles = 8; } },
-    { 0xCA, /* SET 1,D    */ [this]() { _set(d(), 1); _pc += 2; _cycles = 8; } },
-    { 0xCB, /* SET 1,E    */ [this]() { _set(e(), 1); _pc += 2; _cycles = 8; } },
-    { 0xCC, /* SET 1,H    */ [this]() { _set(h(), 1); _pc += 2; _cycles = 8; } },
-    { 0xCD, /* SET 1,L    */ [this]() { _set(l(), 1); _pc += 2; _cycles = 8; } },
-    { 0xCE, /* SET 1,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 1); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xCF, /* SET 1,A    */ [this]() { _set(a(), 1); _pc += 2; _cycles = 8; } },
-
-    { 0xD0, /* SET 2,B    */ [this]() { _set(b(), 2); _pc += 2; _cycles = 8; } },
-    { 0xD1, /* SET 2,C    */ [this]() { _set(c(), 2); _pc += 2; _cycles = 8; } },
-    { 0xD2, /* SET 2,D    */ [this]() { _set(d(), 2); _pc += 2; _cycles = 8; } },
-    { 0xD3, /* SET 2,E    */ [this]() { _set(e(), 2); _pc += 2; _cycles = 8; } },
-    { 0xD4, /* SET 2,H    */ [this]() { _set(h(), 2); _pc += 2; _cycles = 8; } },
-    { 0xD5, /* SET 2,L    */ [this]() { _set(l(), 2); _pc += 2; _cycles = 8; } },
-    { 0xD6, /* SET 2,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 2); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xD7, /* SET 2,A    */ [this]() { _set(a(), 2); _pc += 2; _cycles = 8; } },
-
-    { 0xD8, /* SET 3,B    */ [this]() { _set(b(), 3); _pc += 2; _cycles = 8; } },
-    { 0xD9, /* SET 3,C    */ [this]() { _set(c(), 3); _pc += 2; _cycles = 8; } },
-    { 0xDA, /* SET 3,D    */ [this]() { _set(d(), 3); _pc += 2; _cycles = 8; } },
-    { 0xDB, /* SET 3,E    */ [this]() { _set(e(), 3); _pc += 2; _cycles = 8; } },
-    { 0xDC, /* SET 3,H    */ [this]() { _set(h(), 3); _pc += 2; _cycles = 8; } },
-    { 0xDD, /* SET 3,L    */ [this]() { _set(l(), 3); _pc += 2; _cycles = 8; } },
-    { 0xDE, /* SET 3,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 3); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xDF, /* SET 3,A    */ [this]() { _set(a(), 3); _pc += 2; _cycles = 8; } },
-
-    { 0xE0, /* SET 4,B    */ [this]() { _set(b(), 4); _pc += 2; _cycles = 8; } },
-    { 0xE1, /* SET 4,C    */ [this]() { _set(c(), 4); _pc += 2; _cycles = 8; } },
-    { 0xE2, /* SET 4,D    */ [this]() { _set(d(), 4); _pc += 2; _cycles = 8; } },
-    { 0xE3, /* SET 4,E    */ [this]() { _set(e(), 4); _pc += 2; _cycles = 8; } },
-    { 0xE4, /* SET 4,H    */ [this]() { _set(h(), 4); _pc += 2; _cycles = 8; } },
-    { 0xE5, /* SET 4,L    */ [this]() { _set(l(), 4); _pc += 2; _cycles = 8; } },
-    { 0xE6, /* SET 4,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 4); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xE7, /* SET 4,A    */ [this]() { _set(a(), 4); _pc += 2; _cycles = 8; } },
-
-    { 0xE8, /* SET 5,B    */ [this]() { _set(b(), 5); _pc += 2; _cycles = 8; } },
-    { 0xE9, /* SET 5,C    */ [this]() { _set(c(), 5); _pc += 2; _cycles = 8; } },
-    { 0xEA, /* SET 5,D    */ [this]() { _set(d(), 5); _pc += 2; _cycles = 8; } },
-    { 0xEB, /* SET 5,E    */ [this]() { _set(e(), 5); _pc += 2; _cycles = 8; } },
-    { 0xEC, /* SET 5,H    */ [this]() { _set(h(), 5); _pc += 2; _cycles = 8; } },
-    { 0xED, /* SET 5,L    */ [this]() { _set(l(), 5); _pc += 2; _cycles = 8; } },
-    { 0xEE, /* SET 5,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 5); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xEF, /* SET 5,A    */ [this]() { _set(a(), 5); _pc += 2; _cycles = 8; } },
-
-    { 0xF0, /* SET 6,B    */ [this]() { _set(b(), 6); _pc += 2; _cycles = 8; } },
-    { 0xF1, /* SET 6,C    */ [this]() { _set(c(), 6); _pc += 2; _cycles = 8; } },
-    { 0xF2, /* SET 6,D    */ [this]() { _set(d(), 6); _pc += 2; _cycles = 8; } },
-    { 0xF3, /* SET 6,E    */ [this]() { _set(e(), 6); _pc += 2; _cycles = 8; } },
-    { 0xF4, /* SET 6,H    */ [this]() { _set(h(), 6); _pc += 2; _cycles = 8; } },
-    { 0xF5, /* SET 6,L    */ [this]() { _set(l(), 6); _pc += 2; _cycles = 8; } },
-    { 0xF6, /* SET 6,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 6); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xF7, /* SET 6,A    */ [this]() { _set(a(), 6); _pc += 2; _cycles = 8; } },
-
-    { 0xF8, /* SET 7,B    */ [this]() { _set(b(), 7); _pc += 2; _cycles = 8; } },
-    { 0xF9, /* SET 7,C    */ [this]() { _set(c(), 7); _pc += 2; _cycles = 8; } },
-    { 0xFA, /* SET 7,D    */ [this]() { _set(d(), 7); _pc += 2; _cycles = 8; } },
-    { 0xFB, /* SET 7,E    */ [this]() { _set(e(), 7); _pc += 2; _cycles = 8; } },
-    { 0xFC, /* SET 7,H    */ [this]() { _set(h(), 7); _pc += 2; _cycles = 8; } },
-    { 0xFD, /* SET 7,L    */ [this]() { _set(l(), 7); _pc += 2; _cycles = 8; } },
-    { 0xFE, /* SET 7,(HL) */ [this]() { reg_t i = _mm.read(hl()); _set(i, 7); _mm.write(hl(), i); _pc += 2; _cycles = 16; } },
-    { 0xFF, /* SET 7,A    */ [this]() { _set(a(), 7); _pc += 2; _cycles = 8; } },
-  };
+    else {
+      if (half_carry_flag())
+        va = (va - 0x06) & 0xFF;
+
+      if (carry_flag())
+        va -= 0x60;
+    }
+
+    if ((va & 0x100) == 0x100) {
+      carry_flag(true);
+    }
+
+    half_carry_flag(false);
+    zero_flag((va & 0xFF) == 0);
+    a() = va & 0xFF;
+  }
+
+  wide_reg_t _sp_plus_n()
+  {
+    // FIXME SHAMELESS COPY
+    wide_reg_t reg = sp();
+    int8_t   value = b1();
+
+    int result = static_cast<int>(reg + value);
+
+    zero_flag(false);
+    substract_flag(false);
+    half_carry_flag(((reg ^ value ^ (result & 0xFFFF)) & 0x10) == 0x10);
+    carry_flag(((reg ^ value ^ (result & 0xFFFF)) & 0x100) == 0x100);
+
+    return static_cast<wide_reg_t>(result);
+  }
+
+  template <reg_t OP>
+  void _cb()
+  {
+    constexpr reg_t x = OP >> 6;
+    constexpr reg_t y = (OP >> 3) & 7;
+    constexpr reg_t z = OP & 7;
+
+    if constexpr (x == 0) {
+      _modify_r<z>([this](reg_t& r) {
+        if constexpr (y == 0) _rlc(r, true);
+        if constexpr (y == 1) _rrc(r, true);
+        if constexpr (y == 2) _rl(r, true);
+        if constexpr (y == 3) _rr(r, true);
+        if constexpr (y == 4) _sla(r);
+        if constexpr (y == 5) _sra(r);
+        if constexpr (y == 6) _swap(r);
+        if constexpr (y == 7) _srl(r);
+      });
+    }
+    else if constexpr (x == 1) {
+      // FIXME: BIT 0-2,(HL) write the value back, 3-7 do not
+      if constexpr (z == 6 and y < 3)
+        _modify_r<z>([this](reg_t& r) { _bit(r, y); });
+      else
+        _bit(_read_r<z>(), y);
+    }
+    else if constexpr (x == 2)
+      _modify_r<z>([this](reg_t& r) { _res(r, y); });
+    else
+      _modify_r<z>([this](reg_t& r) { _set(r, y); });
+
+    _pc += 2;
+    _cycles = Opcodes::cycles(0xCB, OP);
+  }
+
 };
+
+inline const std::array<CP::handler_t, 0x100> CP::_ops =
+  CP::_make_ops(std::make_index_sequence<0x100>());
+
+inline const std::array<CP::handler_t, 0x100> CP::_cb_ops =
+  CP::_make_cb_ops(std::make_index_sequence<0x100>());
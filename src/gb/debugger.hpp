@@ -0,0 +1,153 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Watchpoints and breakpoints. Watched addresses mark their page, so
+// accesses to other pages cost one table lookup, and CP only looks at
+// breakpoints while some are set. A hit stops the cpu before its next
+// instruction until resume() is called.
+class Debugger
+{
+public:
+  static const reg_t WATCH_READ  = 0x01;
+  static const reg_t WATCH_WRITE = 0x02;
+
+  struct Hit
+  {
+    enum class Kind { None, Break, Read, Write };
+
+    Kind       kind  = Kind::None;
+    uint16_t   bank  = 0;
+    wide_reg_t addr  = 0;
+    reg_t      value = 0;
+  };
+
+  // kinds of 0 removes the watchpoint
+  void watch(wide_reg_t addr, reg_t kinds)
+  {
+    if (kinds)
+      _watches[addr] = kinds;
+    else
+      _watches.erase(addr);
+
+    _pages = {};
+    for (auto const& watch : _watches)
+      _pages[watch.first >> 8] |= watch.second;
+  }
+
+  // what is watched somewhere in the page of addr
+  reg_t watched_page(wide_reg_t addr) const
+  {
+    return _pages[addr >> 8];
+  }
+
+  bool watching() const
+  {
+    return not _watches.empty();
+  }
+
+  void break_at(uint16_t bank, wide_reg_t pc, bool enable = true)
+  {
+    auto& bits = _breakpoints[bank];
+    if (bits.empty())
+      bits.resize(0x10000 / 64);
+
+    auto const mask = uint64_t(1) << (pc & 63);
+    auto const set  = (bits[pc >> 6] & mask) != 0;
+    if (set == enable)
+      return;
+
+    bits[pc >> 6] ^= mask;
+    _breakpoint_count += enable ? 1 : -1;
+  }
+
+  bool has_breakpoints() const
+  {
+    return _breakpoint_count > 0;
+  }
+
+  bool armed() const
+  {
+    return watching() or has_breakpoints();
+  }
+
+  // true if the instruction at pc must not run
+  bool breaks_at(uint16_t bank, wide_reg_t pc)
+  {
+    if (_skip) {
+      _skip = false;
+      if (pc == _skip_pc)
+        return false;
+    }
+
+    auto const it = _breakpoints.find(bank);
+    if (it == _breakpoints.end() or not (it->second[pc >> 6] & (uint64_t(1) << (pc & 63))))
+      return false;
+
+    _stop({ Hit::Kind::Break, bank, pc, 0 });
+    return true;
+  }
+
+  // set by the cpu around an instruction, accesses of the ppu, timer and
+  // input are not checked
+  void executing(bool executing)
+  {
+    _executing = executing;
+  }
+
+  void access(Hit::Kind kind, wide_reg_t addr, reg_t value)
+  {
+    if (not _executing)
+      return;
+
+    auto const it = _watches.find(addr);
+    auto const kinds = kind == Hit::Kind::Read ? WATCH_READ : WATCH_WRITE;
+    if (it != _watches.end() and (it->second & kinds))
+      _stop({ kind, 0, addr, value });
+  }
+
+  bool stopped() const
+  {
+    return _stopped;
+  }
+
+  Hit const& hit() const
+  {
+    return _hit;
+  }
+
+  // continues, stepping over a breakpoint the cpu stopped at
+  void resume()
+  {
+    _skip    = _stopped and _hit.kind == Hit::Kind::Break;
+    _skip_pc = _hit.addr;
+    _stopped = false;
+    _hit     = Hit();
+  }
+
+private:
+  void _stop(Hit const& hit)
+  {
+    if (_stopped)
+      return;
+
+    _stopped = true;
+    _hit     = hit;
+  }
+
+  std::map<wide_reg_t, reg_t>                          _watches;
+  std::array<reg_t, 0x100>                             _pages            = {};
+  std::unordered_map<uint16_t, std::vector<uint64_t>>  _breakpoints;
+  int                                                  _breakpoint_count = 0;
+
+  bool       _executing = false;
+  bool       _stopped   = false;
+  Hit        _hit;
+  bool       _skip      = false;
+  wide_reg_t _skip_pc   = 0;
+};
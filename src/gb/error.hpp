@@ -8,6 +8,13 @@ public:
   enum class Code {
     None,
     RomNotSupported,
+    FileNotAccessible,
+    CacheOutdated,
+    TraceInvalid,
+    CheatInvalid,
+    StateInvalid,
+    MovieInvalid,
+    WorkerFailed,
   };
 
   Error() = default;
@@ -41,6 +48,20 @@ public:
       return "No error";
     case Code::RomNotSupported: 
       return "Rom is not supported.";
+    case Code::FileNotAccessible:
+      return "File could not be accessed.";
+    case Code::CacheOutdated:
+      return "Cache was written for another rom or build.";
+    case Code::TraceInvalid:
+      return "Trace is damaged or was written by another version.";
+    case Code::CheatInvalid:
+      return "Cheat is neither a Game Genie nor a GameShark code.";
+    case Code::StateInvalid:
+      return "State is damaged or was saved for another rom or version.";
+    case Code::MovieInvalid:
+      return "Movie is damaged or was recorded with another rom or version.";
+    case Code::WorkerFailed:
+      return "Worker process could not be started or ended unexpectedly.";
     default:
       return "No error text specified.";
     }
@@ -4,12 +4,20 @@
 #include "mm.hpp"
 #include "gr.hpp"
 #include "cp.hpp"
+#include "backends.hpp"
+#include "battery.hpp"
+#include "cheats.hpp"
 #include "input.hpp"
+#include "log.hpp"
 #include "timer.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <stdio.h>
+#include <string.h>
 
 class GB
 {
@@ -19,20 +27,51 @@ public:
   typedef std::vector<reg_t> cartridge_t;
   typedef std::vector<reg_t> mem_t;
 
+  GB()
+  {
+    _cp.quiet_ticks([this] (reg_t enabled) { return _quiet_ticks(enabled); });
+    backend(Backend::Kind::Cached);
+  }
+
+  // An independent machine in the same state, sharing the rom image. The
+  // clone decodes code again in a backend of its own, the given kind or
+  // the one of this machine, and starts without trace and statistics.
+  std::unique_ptr<GB> clone() const
+  {
+    return clone(backend());
+  }
+
+  std::unique_ptr<GB> clone(Backend::Kind kind) const
+  {
+    std::unique_ptr<GB> gb(new GB(*this));
+    if (not gb->backend(kind))
+      gb->backend(Backend::Kind::Cached);
+
+    return gb;
+  }
+
   Error insert_rom(cartridge_t const& cartridge)
   {
     return _mm.insert_rom(cartridge);
   }
 
+  // shares the image with every other GB it is inserted into
+  Error insert_rom(RomImage::handle_t image)
+  {
+    return _mm.insert_rom(std::move(image));
+  }
+
   Error load_ram(mem_t const& ram)
   {
     return _mm.load_ram(ram);
   }
 
-  void power_on()
+  // fast_boot skips the boot rom and its logo scroll
+  void power_on(bool fast_boot = false)
   {
-    _mm.power_on();
-    _cp.power_on();
+    _mm.power_on(not fast_boot);
+    _cp.power_on(not fast_boot);
+    _gr.power_on();
     _t.power_on();
     _in.power_on();
   }
@@ -47,16 +86,93 @@ public:
   void start(bool down) { _in.start(down); }
   void select(bool down) { _in.select(down); }
 
+  // Input::BUTTON_ bits
+  reg_t buttons() const { return _in.buttons(); }
+  void buttons(reg_t mask) { _in.buttons(mask); }
+
   reg_t mem(wide_reg_t addr) const
   {
     return _mm.read(addr);
   }
 
-  mem_t ram() const
+  mem_t const& ram() const
   {
     return _mm.ram();
   }
 
+  // The whole machine: "YGBS", version, rom hash, size, then cpu, memory
+  // and cartridge, ppu, timer and input. Saving into the same vector again
+  // does not allocate. Debugger, cheats and statistics are not included.
+  void save_state(std::vector<uint8_t>& data) const
+  {
+    data.clear();
+
+    StateWriter state(data);
+    _save_state(state);
+
+    uint32_t const size = data.size();
+    memcpy(data.data() + STATE_SIZE_OFFSET, &size, sizeof(size));
+  }
+
+  // nothing is restored unless the header matches this rom, build and
+  // cartridge ram, the state is exactly as long as this machine's and
+  // every value can be restored without reading out of bounds or hanging
+  Error load_state(std::vector<uint8_t> const& data)
+  {
+    return load_state(data.data(), data.size());
+  }
+
+  Error load_state(uint8_t const* data, size_t data_size)
+  {
+    StateReader state(data, data_size);
+
+    char     magic[4] = {};
+    uint32_t version  = 0;
+    uint64_t hash     = 0;
+    uint32_t size     = 0;
+    uint32_t ram_size = 0;
+
+    state.get(magic);
+    state.get(version);
+    state.get(hash);
+    state.get(size);
+    state.get(ram_size);
+
+    // the components cannot fail to load what is left
+    StateWriter expected;
+    _save_state(expected);
+
+    if (state.failed() or
+        memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 or
+        version  != STATE_VERSION or
+        hash     != _mm.image_hash() or
+        ram_size != _mm.ram().size() or
+        size     != data_size or
+        size     != expected.size())
+      return Error(Error::Code::StateInvalid);
+
+    StateReader values = state;
+    _skip_state(values, _cp);
+    if (not _mm.check_state(values) or
+        not _gr.check_state(values) or
+        not _t.check_state(values))
+      return Error(Error::Code::StateInvalid);
+
+    _cp.load_state(state);
+    _mm.load_state(state);
+    _gr.load_state(state);
+    _t.load_state(state);
+    _in.load_state(state);
+
+    return Error::NoError();
+  }
+
+  // see Cartridge::take_dirty_ram_banks
+  uint32_t take_dirty_ram_banks()
+  {
+    return _mm.take_dirty_ram_banks();
+  }
+
   reg_t screen_width() const
   {
     return _gr.width();
@@ -67,11 +183,18 @@ public:
     return _gr.height();
   }
 
-  GR::screen_t screen() const
+  // stays at the same address, run_frame() draws into it
+  GR::screen_t const& screen() const
   {
     return _gr.screen();
   }
 
+  // see GR::render
+  void render(bool enable)
+  {
+    _gr.render(enable);
+  }
+
   bool is_v_blank_completed() const
   {
     return _gr.lx() == 0 and _gr.ly() == 0;
@@ -79,10 +202,6 @@ public:
 
   void tick()
   {
-    if (not _mm.is_rom_verified() and _cp.pc() >= 0x0100) {
-      _mm.rom_verified();
-    }
-
     _cp.tick();
     _in.tick();
     _t.tick();
@@ -91,19 +210,215 @@ public:
     // FIXME: remove this serial dbg hack
     if (_mm.read(0xFF02)) {
       _mm.write(0xFF02, 0x00);
-      printf("SERIAL:%c\n", _mm.read(0xFF01));
+      Log::line("SERIAL:%c", _mm.read(0xFF01));
     }
   }
 
+  // returns early when the debugger stopped the cpu
+  void run_frame()
+  {
+    do {
+      tick();
+    }
+    while(not is_v_blank_completed() and not _mm.debugger().stopped());
+
+    if (is_v_blank_completed())
+      _cheats.poke(_mm);
+  }
+
+  // Game Genie codes take effect right away, GameShark codes at the end
+  // of every frame; those for a cartridge ram bank are only accepted after
+  // power_on and if the cartridge has that bank
+  Error add_cheat(std::string const& code)
+  {
+    auto const error = _cheats.add(code, _mm.ram().size());
+    if (error.is_set())
+      return error;
+
+    _apply_cheats();
+    return Error::NoError();
+  }
+
+  void clear_cheats()
+  {
+    _cheats.clear();
+    _apply_cheats();
+  }
+
+  Cheats const& cheats() const
+  {
+    return _cheats;
+  }
+
   void dbg()
   {
     _cp.dbg();
   }
 
+  CP const& cp() const
+  {
+    return _cp;
+  }
+
+  Trace& trace()
+  {
+    return _cp.trace();
+  }
+
+  Profiler& profiler()
+  {
+    return _cp.profiler();
+  }
+
+  OpcodeStats& opcode_stats()
+  {
+    return _cp.opcode_stats();
+  }
+
+  Debugger& debugger()
+  {
+    return _mm.debugger();
+  }
+
+  MM const& mm() const
+  {
+    return _mm;
+  }
+
+  Backend::Kind backend() const
+  {
+    return _cp.backend().kind();
+  }
+
+  // Replaces the cpu backend, also between frames of a running game.
+  // Returns false and keeps the current one if kind is not available.
+  bool backend(Backend::Kind kind)
+  {
+    auto backend = _gen_backend(kind);
+    if (not backend)
+      return false;
+
+    _cp.backend(std::move(backend));
+    return true;
+  }
+
+  // the statistics are nullptr if the backend does not collect them
+  BlockCache::Stats const* block_stats() const
+  {
+    return _cp.backend().block_stats();
+  }
+
+  Backend::idiom_stats_t const* idiom_stats() const
+  {
+    return _cp.backend().idiom_stats();
+  }
+
+  JitStats const* jit_stats() const
+  {
+    return _cp.backend().jit_stats();
+  }
+
+  Error save_code_cache(std::string const& path) const
+  {
+    return _cp.backend().save_code_cache(path);
+  }
+
+  // must be called after power_on
+  Error load_code_cache(std::string const& path)
+  {
+    return _cp.backend().load_code_cache(path);
+  }
+
+  void jit_verify(bool enable)
+  {
+    _cp.backend().jit_verify(enable);
+  }
+
 private:
+  // the backend is left to clone()
+  GB(GB const& other)
+    : _mm(other._mm)
+    , _cp(other._cp, _mm)
+    , _gr(other._gr, _mm)
+    , _t(other._t, _mm)
+    , _in(other._in, _mm)
+    , _cheats(other._cheats)
+  {
+    _cp.quiet_ticks([this] (reg_t enabled) { return _quiet_ticks(enabled); });
+  }
+
+  GB& operator=(GB const&) = delete;
+
+  // how long the cpu may run ahead of the other components in one go
+  uint32_t _quiet_ticks(reg_t enabled) const
+  {
+    return std::min({
+      _gr.quiet_ticks(enabled),
+      _t.quiet_ticks(enabled),
+      _in.quiet_ticks(enabled) });
+  }
+
+  static constexpr char const STATE_MAGIC[4]     = { 'Y', 'G', 'B', 'S' };
+  static constexpr size_t     STATE_SIZE_OFFSET  = 16;
+
+  // bump whenever a component changes what it saves
+  static constexpr uint32_t   STATE_VERSION      = 4;
+
+  // a component saves the same number of bytes in every state
+  template <typename T>
+  static void _skip_state(StateReader& state, T const& component)
+  {
+    StateWriter size;
+    component.save_state(size);
+    state.skip(size.size());
+  }
+
+  void _save_state(StateWriter& state) const
+  {
+    state.put(STATE_MAGIC);
+    state.put(STATE_VERSION);
+    state.put(_mm.image_hash());
+    state.put(uint32_t(0)); // size, filled in by save_state
+    state.put(static_cast<uint32_t>(_mm.ram().size()));
+
+    _cp.save_state(state);
+    _mm.save_state(state);
+    _gr.save_state(state);
+    _t.save_state(state);
+    _in.save_state(state);
+  }
+
+  std::unique_ptr<Backend> _gen_backend(Backend::Kind kind)
+  {
+    switch (kind) {
+    case Backend::Kind::Reference:
+      return std::make_unique<ReferenceBackend>(_cp, _mm);
+
+    case Backend::Kind::Cached:
+      return std::make_unique<CachedBackend>(_cp, _mm);
+
+    case Backend::Kind::Jit: {
+      auto jit = std::make_unique<JitBackend>(_cp, _mm);
+      if (not jit->available())
+        return nullptr;
+      return jit;
+    }
+    }
+
+    return nullptr;
+  }
+
+  // blocks decoded from the rom before must not be used anymore
+  void _apply_cheats()
+  {
+    _cheats.patch(_mm);
+    _cp.backend().reset();
+  }
+
   MM      _mm;
   CP      _cp      = { _mm };
   GR      _gr      = { _mm };
   Timer   _t       = { _mm };
   Input   _in      = { _mm };
+  Cheats  _cheats;
 };
@@ -4,6 +4,8 @@
 
 #include "mm.hpp"
 
+#include <limits>
+
 class GR
 {
   static const reg_t WIDTH  = 160;
@@ -17,13 +19,62 @@ public:
     , _lx(0)
   {}
 
+  GR(GR const& other, MM& mm)
+    : _mm(mm)
+    , _lx(other._lx)
+    , _screen(other._screen)
+    , _render(other._render)
+  {}
+
   void power_on()
   {
     _lx = 0;
     _screen  = screen_t();
   }
 
-  screen_t screen() const
+  // pixels are shades 0 to 3, four of them are packed into a byte
+  void save_state(StateWriter& state) const
+  {
+    state.put(_lx);
+
+    std::array<reg_t, WIDTH*HEIGHT/4> packed;
+    for (size_t i = 0; i < packed.size(); ++i) {
+      auto const* pixel = &_screen[i * 4];
+      packed[i] = pixel[0] | (pixel[1] << 2) | (pixel[2] << 4) | (pixel[3] << 6);
+    }
+    state.put(packed);
+  }
+
+  void load_state(StateReader& state)
+  {
+    state.get(_lx);
+
+    std::array<reg_t, WIDTH*HEIGHT/4> packed;
+    state.get(packed);
+    static auto const unpacked = [] {
+      std::array<std::array<reg_t, 4>, 256> table;
+      for (size_t byte = 0; byte < table.size(); ++byte) {
+        for (size_t x = 0; x < 4; ++x)
+          table[byte][x] = (byte >> (2 * x)) & 0x03;
+      }
+      return table;
+    }();
+
+    for (size_t i = 0; i < packed.size(); ++i)
+      memcpy(&_screen[i * 4], unpacked[packed[i]].data(), 4);
+  }
+
+  // reads what load_state would, a line is 450 ticks long
+  bool check_state(StateReader& state) const
+  {
+    int lx = 0;
+    state.get(lx);
+    state.skip(WIDTH*HEIGHT/4);
+
+    return lx >= 0 and lx < 450;
+  }
+
+  screen_t const& screen() const
   {
     return _screen;
   }
@@ -45,8 +96,29 @@ public:
   reg_t wx()      const { return _mm.read(0xFF4B); }
   reg_t ly()      const { return _mm.read(0xFF44); }
   reg_t lyc()     const { return _mm.read(0xFF45); }
+
+  // Drawing only reads memory, frames nobody looks at can skip it. The
+  // screen keeps what was drawn last.
+  void render(bool enable) { _render = enable; }
+  bool render() const { return _render; }
   wide_reg_t lx() const { return _lx; }
 
+  // Ticks from now on that request none of the enabled interrupts. Lcd
+  // interrupts are only requested when a line or mode 2 starts, vblank
+  // when line 144 starts.
+  uint32_t quiet_ticks(reg_t enabled) const
+  {
+    if ((enabled & 0x02) and (_mm.read(0xFF41) & 0x78))
+      return (_lx < 360 ? 360 : 450) - _lx - 1;
+
+    if (not (enabled & 0x01))
+      return std::numeric_limits<uint32_t>::max();
+
+    auto const line  = ly();
+    auto const lines = line < 144 ? 143 - line : 297 - line;
+    return 450 - _lx - 1 + lines * 450;
+  }
+
   void ly(reg_t val)
   {
     _mm.write(0xFF44, val, true);
@@ -76,7 +148,8 @@ public:
     }
     else if (lx() == 360) {
       mode = 0x02;
-      _render_scanline(v_ly);
+      if (_render)
+        _render_scanline(v_ly);
       mode_entered = true;
     }
     else if (lx() > 360) {
@@ -88,11 +161,13 @@ public:
     else if (lx() == 0) {
       mode = 0x03;
       mode_entered = true;
-      _render_background(lx(), v_ly);
+      if (_render)
+        _render_background(lx(), v_ly);
     }
     else {
       mode = 0x03;
-      _render_background(lx(), v_ly);
+      if (_render)
+        _render_background(lx(), v_ly);
     }
 
     reg_t ly_lyc = (v_ly == lyc()) << 2;
@@ -291,7 +366,8 @@ private:
 private:
   MM&       _mm;
 
-  int       _lx;
+  int       _lx = 0;
 
-  screen_t  _screen;
+  screen_t  _screen = {};
+  bool      _render = true;
 };
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FNV-1a, used to fingerprint roms, memory and frames
+inline uint64_t hash(void const* data, size_t size, uint64_t seed = 0xCBF29CE484222325ull)
+{
+  auto const* bytes = static_cast<uint8_t const*>(data);
+
+  uint64_t h = seed;
+  for (size_t i = 0; i < size; ++i) {
+    h ^= bytes[i];
+    h *= 0x100000001B3ull;
+  }
+
+  return h;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+
+#include <stddef.h>
+#include <string.h>
+
+// Copy and fill loops that games spend a large part of their startup and
+// scene changes in. A block that consists of exactly one of these loops is
+// tagged when it is decoded and the cpu then runs whole iterations of it at
+// once instead of single instructions.
+class Idioms
+{
+public:
+  enum class Kind : uint8_t
+  {
+    None,
+    CopyBC,     // ld a,(hl+) ; ld (de),a ; inc de ; dec bc ; ld a,b ; or c ; jr nz
+    CopyDeBC,   // ld a,(de) ; ld (hl+),a ; inc de ; dec bc ; ld a,b ; or c ; jr nz
+    CopyB,      // ld a,(hl+) ; ld (de),a ; inc de ; dec b ; jr nz
+    CopyC,      // ld a,(hl+) ; ld (de),a ; inc de ; dec c ; jr nz
+    FillB,      // ld (hl+),a ; dec b ; jr nz
+    FillC,      // ld (hl+),a ; dec c ; jr nz
+    FillDownB,  // ld (hl-),a ; dec b ; jr nz
+    FillDownC,  // ld (hl-),a ; dec c ; jr nz
+    ClearDown,  // ld (hl-),a ; bit 7,h ; jr nz
+  };
+
+  static const size_t COUNT = 10;
+
+  struct Stats
+  {
+    uint64_t runs       = 0;
+    uint64_t iterations = 0;
+  };
+
+  static char const* name(Kind kind)
+  {
+    return _patterns[static_cast<size_t>(kind)].name;
+  }
+
+  static Kind match(reg_t const* code, size_t size)
+  {
+    for (size_t i = 1; i < COUNT; ++i) {
+      auto const& pattern = _patterns[i];
+      if (pattern.size == size and memcmp(pattern.code, code, size) == 0)
+        return static_cast<Kind>(i);
+    }
+
+    return Kind::None;
+  }
+
+private:
+  struct Pattern
+  {
+    char const* name;
+    size_t      size;
+    reg_t       code[9];
+  };
+
+  static constexpr std::array<Pattern, COUNT> _patterns = {{
+    { "none",        0, {} },
+    { "copy bc",     8, { 0x2A, 0x12, 0x13, 0x0B, 0x78, 0xB1, 0x20, 0xF8 } },
+    { "copy bc de",  8, { 0x1A, 0x22, 0x13, 0x0B, 0x78, 0xB1, 0x20, 0xF8 } },
+    { "copy b",      6, { 0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA } },
+    { "copy c",      6, { 0x2A, 0x12, 0x13, 0x0D, 0x20, 0xFA } },
+    { "fill b",      4, { 0x22, 0x05, 0x20, 0xFC } },
+    { "fill c",      4, { 0x22, 0x0D, 0x20, 0xFC } },
+    { "fill down b", 4, { 0x32, 0x05, 0x20, 0xFC } },
+    { "fill down c", 4, { 0x32, 0x0D, 0x20, 0xFC } },
+    { "clear down",  5, { 0x32, 0xCB, 0x7C, 0x20, 0xFB } },
+  }};
+};
@@ -3,13 +3,46 @@
 #include "types.h"
 #include "mm.hpp"
 
+#include <limits>
+
 class Input
 {
 public:
+  static const reg_t BUTTON_RIGHT  = 0x01;
+  static const reg_t BUTTON_LEFT   = 0x02;
+  static const reg_t BUTTON_UP     = 0x04;
+  static const reg_t BUTTON_DOWN   = 0x08;
+  static const reg_t BUTTON_A      = 0x10;
+  static const reg_t BUTTON_B      = 0x20;
+  static const reg_t BUTTON_SELECT = 0x40;
+  static const reg_t BUTTON_START  = 0x80;
+
   Input(MM& mm)
     : _mm(mm)
   {}
 
+  Input(Input const& other, MM& mm)
+    : _mm(mm)
+    , _left(other._left)
+    , _right(other._right)
+    , _up(other._up)
+    , _down(other._down)
+    , _a(other._a)
+    , _b(other._b)
+    , _start(other._start)
+    , _select(other._select)
+    , _old_left(other._old_left)
+    , _old_right(other._old_right)
+    , _old_up(other._old_up)
+    , _old_down(other._old_down)
+    , _old_a(other._old_a)
+    , _old_b(other._old_b)
+    , _old_start(other._old_start)
+    , _old_select(other._old_select)
+    , _button_changed(other._button_changed)
+    , _old_p1(other._old_p1)
+  {}
+
   void power_on()
   {
     _left           = false;
@@ -20,10 +53,48 @@ public:
     _b              = false;
     _start          = false;
     _select         = false;
+    _old_left       = false;
+    _old_right      = false;
+    _old_up         = false;
+    _old_down       = false;
+    _old_a          = false;
+    _old_b          = false;
+    _old_start      = false;
+    _old_select     = false;
     _button_changed = true;
     _old_p1         = 100;
   }
 
+  void save_state(StateWriter& state) const
+  {
+    state.put(_left); state.put(_right); state.put(_up); state.put(_down);
+    state.put(_a); state.put(_b); state.put(_start); state.put(_select);
+    state.put(_old_left); state.put(_old_right); state.put(_old_up); state.put(_old_down);
+    state.put(_old_a); state.put(_old_b); state.put(_old_start); state.put(_old_select);
+    state.put(_button_changed);
+    state.put(_old_p1);
+  }
+
+  void load_state(StateReader& state)
+  {
+    state.get(_left); state.get(_right); state.get(_up); state.get(_down);
+    state.get(_a); state.get(_b); state.get(_start); state.get(_select);
+    state.get(_old_left); state.get(_old_right); state.get(_old_up); state.get(_old_down);
+    state.get(_old_a); state.get(_old_b); state.get(_old_start); state.get(_old_select);
+    state.get(_button_changed);
+    state.get(_old_p1);
+  }
+
+  // ticks from now on that request none of the enabled interrupts; a
+  // button pressed since the last tick requests one right away
+  uint32_t quiet_ticks(reg_t enabled) const
+  {
+    if ((enabled & 0x10) and _button_changed)
+      return 0;
+
+    return std::numeric_limits<uint32_t>::max();
+  }
+
   void tick()
   {
     reg_t p1 =_mm.read(0xFF00) & 0x30;
@@ -70,37 +141,74 @@ public:
     _button_changed = false;
   }
 
-  void left(bool down)   { _button_changed = true; _left = down;   }
-  void right(bool down)  { _button_changed = true; _right = down;  }
-  void up(bool down)     { _button_changed = true; _up = down;     }
-  void down(bool down)   { _button_changed = true; _down = down;   }
+  // Only actual changes count, so the machine depends on which buttons
+  // are held in a frame and not on how often a frontend says so.
+  void left(bool down)   { _set(_left, down);   }
+  void right(bool down)  { _set(_right, down);  }
+  void up(bool down)     { _set(_up, down);     }
+  void down(bool down)   { _set(_down, down);   }
+
+  void a(bool down)      { _set(_a, down);      }
+  void b(bool down)      { _set(_b, down);      }
+  void start(bool down)  { _set(_start, down);  }
+  void select(bool down) { _set(_select, down); }
 
-  void a(bool down)      { _button_changed = true; _a = down;      }
-  void b(bool down)      { _button_changed = true; _b = down;      }
-  void start(bool down)  { _button_changed = true; _start = down;  }
-  void select(bool down) { _button_changed = true; _select = down; }
+  // all buttons as BUTTON_ bits
+  reg_t buttons() const
+  {
+    return
+      (_right  ? BUTTON_RIGHT  : 0) |
+      (_left   ? BUTTON_LEFT   : 0) |
+      (_up     ? BUTTON_UP     : 0) |
+      (_down   ? BUTTON_DOWN   : 0) |
+      (_a      ? BUTTON_A      : 0) |
+      (_b      ? BUTTON_B      : 0) |
+      (_select ? BUTTON_SELECT : 0) |
+      (_start  ? BUTTON_START  : 0);
+  }
+
+  void buttons(reg_t mask)
+  {
+    right(mask & BUTTON_RIGHT);
+    left(mask & BUTTON_LEFT);
+    up(mask & BUTTON_UP);
+    down(mask & BUTTON_DOWN);
+    a(mask & BUTTON_A);
+    b(mask & BUTTON_B);
+    select(mask & BUTTON_SELECT);
+    start(mask & BUTTON_START);
+  }
 
 private:
+  void _set(bool& button, bool down)
+  {
+    if (button == down)
+      return;
+
+    button          = down;
+    _button_changed = true;
+  }
+
   MM&   _mm;
 
-  bool  _left;
-  bool  _right;
-  bool  _up;
-  bool  _down;
-  bool  _a;
-  bool  _b;
-  bool  _start;
-  bool  _select;
-
-  bool  _old_left;
-  bool  _old_right;
-  bool  _old_up;
-  bool  _old_down;
-  bool  _old_a;
-  bool  _old_b;
-  bool  _old_start;
-  bool  _old_select;
-
-  bool  _button_changed;
-  reg_t _old_p1;
+  bool  _left           = false;
+  bool  _right          = false;
+  bool  _up             = false;
+  bool  _down           = false;
+  bool  _a              = false;
+  bool  _b              = false;
+  bool  _start          = false;
+  bool  _select         = false;
+
+  bool  _old_left       = false;
+  bool  _old_right      = false;
+  bool  _old_up         = false;
+  bool  _old_down       = false;
+  bool  _old_a          = false;
+  bool  _old_b          = false;
+  bool  _old_start      = false;
+  bool  _old_select     = false;
+
+  bool  _button_changed = false;
+  reg_t _old_p1         = 100;
 };
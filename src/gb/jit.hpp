@@ -0,0 +1,616 @@
+#pragma once
+
+#include "types.h"
+#include "block_cache.hpp"
+#include "log.hpp"
+
+#include <vector>
+
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define YAGBE_JIT 1
+#endif
+
+struct JitStats
+{
+  uint64_t compiled     = 0;
+  uint64_t rejected     = 0;
+  uint64_t mismatches   = 0;
+  uint64_t runs         = 0;
+  uint64_t instructions = 0;
+  uint64_t flushes      = 0;
+};
+
+// Translates hot rom blocks into x86-64 code. Only instructions that work
+// on registers alone are translated; memory access and everything else
+// stays with the interpreter, which keeps bus and i/o timing in one place.
+// Loads, 8 bit arithmetic, INC and DEC with their flags and the JR and JP
+// exits become x86 instructions; rotates, CB, DAA and 16 bit arithmetic
+// call their interpreter handler directly, saving decode and dispatch.
+// Every instruction charges a fixed number of cycles, the whole block is
+// charged at its exit. Interrupts are only recognized between blocks, so a
+// translation only runs if it ends before the next one is requested.
+template <typename Cpu>
+class Jit
+{
+  typedef void (*native_fn_t)(Cpu*);
+
+  struct Regs
+  {
+    reg_t      a, b, c, d, e, f, h, l;
+    wide_reg_t sp, pc;
+    uint32_t   cycles;
+
+    bool operator==(Regs const& o) const
+    {
+      return
+        a == o.a and b == o.b and c == o.c and d == o.d and
+        e == o.e and f == o.f and h == o.h and l == o.l and
+        sp == o.sp and pc == o.pc and cycles == o.cycles;
+    }
+  };
+
+public:
+  typedef JitStats Stats;
+
+  static const uint32_t HOT_THRESHOLD = 8;
+  static const size_t   MIN_LENGTH    = 2;
+  static const size_t   ARENA_SIZE    = 4 * 1024 * 1024;
+  static const size_t   MAX_CODE_SIZE = 96 * BlockCache::MAX_BLOCK_LENGTH + 64;
+
+  Jit(Cpu& cpu)
+    : _cpu(cpu)
+  {}
+
+  ~Jit()
+  {
+#if YAGBE_JIT
+    if (_arena)
+      munmap(_arena, ARENA_SIZE);
+#endif
+  }
+
+  Jit(Jit const&) = delete;
+  Jit& operator=(Jit const&) = delete;
+
+  static bool available()
+  {
+#if YAGBE_JIT
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool enabled() const
+  {
+    return _enabled;
+  }
+
+  bool enable(bool enable)
+  {
+    _enabled = enable and available() and _map_arena();
+    return _enabled;
+  }
+
+  void verify(bool enable)
+  {
+    _verify = enable;
+  }
+
+  Stats const& stats() const
+  {
+    return _stats;
+  }
+
+  // forgets all translations; blocks are about to be dropped
+  void reset()
+  {
+    _compiled.clear();
+    _used = 0;
+  }
+
+  // executes the native translation of block if there is one that takes
+  // at most max_ticks and returns the number of instructions it covered
+  size_t run(BlockCache::Block& block, uint32_t max_ticks)
+  {
+    if (not block.native) {
+      if (block.heat > HOT_THRESHOLD or ++block.heat < HOT_THRESHOLD)
+        return 0;
+
+      ++block.heat;
+      if (not _compile(block))
+        return 0;
+    }
+
+    if (block.native_ticks > max_ticks)
+      return 0;
+
+    if (_verify and not block.verified and not _check(block))
+      return 0;
+
+    reinterpret_cast<native_fn_t>(const_cast<void*>(block.native))(&_cpu);
+
+    ++_stats.runs;
+    _stats.instructions += block.native_len;
+
+    return block.native_len;
+  }
+
+private:
+  static void _call_handler(Cpu* cpu, uint32_t ins)
+  {
+    cpu->_ins.op = ins;
+    cpu->_ins.b1 = ins >> 8;
+    cpu->_ins.b2 = ins >> 16;
+    cpu->_execute();
+  }
+
+  static bool _is_branch(reg_t op)
+  {
+    switch (op) {
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+    case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: // JP
+    case 0xE9:                                             // JP (HL)
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // instructions without memory access, i/o or interrupt side effects
+  static bool _is_translatable(BlockCache::Ins const& ins)
+  {
+    auto const op = ins.op;
+
+    if (op == 0xCB)
+      return (ins.b1 & 0x07) != 0x06;
+
+    if (op >= 0x40 and op < 0xC0)
+      return (op & 0x07) != 0x06 and (op >= 0x80 or (op & 0x38) != 0x30);
+
+    switch (op) {
+    case 0x00:
+    case 0x01: case 0x11: case 0x21: case 0x31: // LD rr,nn
+    case 0x03: case 0x13: case 0x23: case 0x33: // INC rr
+    case 0x0B: case 0x1B: case 0x2B: case 0x3B: // DEC rr
+    case 0x09: case 0x19: case 0x29: case 0x39: // ADD HL,rr
+    case 0x04: case 0x0C: case 0x14: case 0x1C: // INC r
+    case 0x24: case 0x2C: case 0x3C:
+    case 0x05: case 0x0D: case 0x15: case 0x1D: // DEC r
+    case 0x25: case 0x2D: case 0x3D:
+    case 0x06: case 0x0E: case 0x16: case 0x1E: // LD r,n
+    case 0x26: case 0x2E: case 0x3E:
+    case 0x07: case 0x0F: case 0x17: case 0x1F: // rotate A
+    case 0x27: case 0x2F: case 0x37: case 0x3F: // DAA, CPL, SCF, CCF
+    case 0xC6: case 0xCE: case 0xD6: case 0xDE: // ALU A,n
+    case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+    case 0xE8: case 0xF8: case 0xF9:            // SP arithmetic
+      return true;
+    default:
+      return _is_branch(op);
+    }
+  }
+
+  bool _map_arena()
+  {
+#if YAGBE_JIT
+    if (_arena)
+      return true;
+
+    void* arena = mmap(
+      nullptr,
+      ARENA_SIZE,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+
+    if (arena == MAP_FAILED) {
+      Log::line("JIT: could not map code arena");
+      return false;
+    }
+
+    _arena = static_cast<uint8_t*>(arena);
+    mprotect(_arena, ARENA_SIZE, PROT_READ | PROT_EXEC);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool _compile(BlockCache::Block& block)
+  {
+#if YAGBE_JIT
+    size_t len = 0;
+    while (len < block.ins.size() and _is_translatable(block.ins[len])) {
+      ++len;
+      if (_is_branch(block.ins[len - 1].op))
+        break;
+    }
+
+    if (len < MIN_LENGTH) {
+      ++_stats.rejected;
+      return false;
+    }
+
+    if (_used + MAX_CODE_SIZE > ARENA_SIZE)
+      _flush();
+
+    _code.clear();
+    _emit_block(block, len);
+
+    mprotect(_arena, ARENA_SIZE, PROT_READ | PROT_WRITE);
+    memcpy(_arena + _used, _code.data(), _code.size());
+    mprotect(_arena, ARENA_SIZE, PROT_READ | PROT_EXEC);
+
+    block.native       = _arena + _used;
+    block.native_len   = len;
+    block.native_ticks = _ticks(block, len);
+    _used += (_code.size() + 15) & ~size_t(15);
+    _compiled.push_back(&block);
+
+    ++_stats.compiled;
+    return true;
+#else
+    (void)block;
+    return false;
+#endif
+  }
+
+  void _flush()
+  {
+    for (auto block : _compiled) {
+      block->native       = nullptr;
+      block->native_len   = 0;
+      block->native_ticks = 0;
+      block->heat         = 0;
+      block->verified     = false;
+    }
+
+    reset();
+    ++_stats.flushes;
+  }
+
+  // runs the translation and the interpreter from the same registers and
+  // compares the outcome; a block that disagrees is never run natively
+  bool _check(BlockCache::Block& block)
+  {
+    auto const before = _save();
+
+    reinterpret_cast<native_fn_t>(const_cast<void*>(block.native))(&_cpu);
+    auto const native = _save();
+
+    _restore(before);
+    uint32_t cycles = 0;
+    for (size_t i = 0; i < block.native_len; ++i) {
+      _cpu._ins = block.ins[i];
+      _cpu._execute();
+      cycles += _cpu._cycles;
+    }
+    _cpu._cycles = cycles + block.native_len - 1;
+    auto const interpreted = _save();
+
+    _restore(before);
+    block.verified = true;
+
+    if (native == interpreted)
+      return true;
+
+    Log::line(
+      "JIT: mismatch in block %04x:%04x (%u instructions)",
+      block.bank,
+      block.ins.front().pc,
+      block.native_len);
+
+    ++_stats.mismatches;
+    block.native       = nullptr;
+    block.native_len   = 0;
+    block.native_ticks = 0;
+    return false;
+  }
+
+  Regs _save() const
+  {
+    return {
+      _cpu._a, _cpu._b, _cpu._c, _cpu._d, _cpu._e, _cpu._f, _cpu._h, _cpu._l,
+      _cpu._sp, _cpu._pc, _cpu._cycles };
+  }
+
+  void _restore(Regs const& r)
+  {
+    _cpu._a = r.a; _cpu._b = r.b; _cpu._c = r.c; _cpu._d = r.d;
+    _cpu._e = r.e; _cpu._f = r.f; _cpu._h = r.h; _cpu._l = r.l;
+    _cpu._sp = r.sp; _cpu._pc = r.pc; _cpu._cycles = r.cycles;
+  }
+
+  int32_t _offset(void const* member) const
+  {
+    return
+      static_cast<char const*>(member) -
+      reinterpret_cast<char const*>(&_cpu);
+  }
+
+  int32_t _reg_offset(int index) const
+  {
+    switch (index) {
+    case 0: return _offset(&_cpu._b);
+    case 1: return _offset(&_cpu._c);
+    case 2: return _offset(&_cpu._d);
+    case 3: return _offset(&_cpu._e);
+    case 4: return _offset(&_cpu._h);
+    case 5: return _offset(&_cpu._l);
+    default: return _offset(&_cpu._a);
+    }
+  }
+
+  // ticks the first len instructions keep the cpu busy for
+  static uint32_t _ticks(BlockCache::Block const& block, size_t len)
+  {
+    uint32_t ticks = 0;
+    for (size_t i = 0; i < len; ++i)
+      ticks += Opcodes::cycles(block.ins[i].op, block.ins[i].b1) + 1;
+
+    return ticks;
+  }
+
+  void _emit_block(BlockCache::Block const& block, size_t len)
+  {
+    // rbx holds the cpu
+    _emit({ 0x53 });                   // push rbx
+    _emit({ 0x48, 0x89, 0xFB });       // mov rbx,rdi
+
+    bool branched = false;
+
+    for (size_t i = 0; i < len; ++i) {
+      auto const& ins = block.ins[i];
+      auto const  op  = ins.op;
+      auto const  y   = (op >> 3) & 0x07;
+
+      if (op == 0x00) {
+      }
+      else if (op >= 0x40 and op < 0x80) {      // LD r,r'
+        _emit({ 0x0F, 0xB6, 0x83 });            // movzx eax,byte [rbx+src]
+        _emit32(_reg_offset(op & 0x07));
+        _emit({ 0x88, 0x83 });                  // mov [rbx+dst],al
+        _emit32(_reg_offset(y));
+      }
+      else if ((op & 0xC7) == 0x06) {           // LD r,n
+        _emit_store8(_reg_offset(y), ins.b1);
+      }
+      else if (op == 0x31) {                    // LD SP,nn
+        _emit_store16(_offset(&_cpu._sp), (ins.b2 << 8) | ins.b1);
+      }
+      else if ((op & 0xCF) == 0x01) {           // LD rr,nn
+        auto const high = (op >> 4) * 2;
+        _emit_store8(_reg_offset(high + 0), ins.b2);
+        _emit_store8(_reg_offset(high + 1), ins.b1);
+      }
+      else if (op >= 0x80 and op < 0xC0) {      // alu A,r
+        _emit_alu(y, op & 0x07, 0);
+      }
+      else if ((op & 0xC7) == 0xC6) {           // alu A,n
+        _emit_alu(y, -1, ins.b1);
+      }
+      else if ((op & 0xC6) == 0x04) {           // INC r, DEC r
+        auto const dec = op & 0x01;
+        _emit({ 0x0F, 0xB6, 0x83 });            // movzx eax,byte [rbx+r]
+        _emit32(_reg_offset(y));
+        _emit({ 0xFE, static_cast<uint8_t>(dec ? 0xC8 : 0xC0) }); // dec al / inc al
+        _emit({ 0x88, 0x83 });                  // mov [rbx+r],al
+        _emit32(_reg_offset(y));
+        _emit({ 0x9F });                        // lahf
+        _emit_flags(0xA0, 0x1F, dec ? 0x40 : 0x00);
+      }
+      else if (op == 0x33 or op == 0x3B) {      // INC SP, DEC SP
+        _emit({ 0x66, 0xFF, static_cast<uint8_t>(op == 0x33 ? 0x83 : 0x8B) });
+        _emit32(_offset(&_cpu._sp));            // inc/dec word [rbx+sp]
+      }
+      else if ((op & 0xC7) == 0x03) {           // INC rr, DEC rr
+        auto const high = (op >> 4) * 2;
+        _emit_load16(_reg_offset(high), _reg_offset(high + 1));
+        _emit({ 0xFF, static_cast<uint8_t>(op & 0x08 ? 0xC8 : 0xC0) }); // dec eax / inc eax
+        _emit({ 0x88, 0x83 });                  // mov [rbx+low],al
+        _emit32(_reg_offset(high + 1));
+        _emit({ 0x88, 0xA3 });                  // mov [rbx+high],ah
+        _emit32(_reg_offset(high));
+      }
+      else if (op == 0x2F) {                    // CPL
+        _emit({ 0xF6, 0x93 });                  // not byte [rbx+a]
+        _emit32(_reg_offset(7));
+        _emit({ 0x80, 0x8B });                  // or byte [rbx+f],N|H
+        _emit32(_offset(&_cpu._f));
+        _emit({ 0x60 });
+      }
+      else if (op == 0x37 or op == 0x3F) {      // SCF, CCF
+        _emit({ 0x0F, 0xB6, 0x83 });            // movzx eax,byte [rbx+f]
+        _emit32(_offset(&_cpu._f));
+        if (op == 0x37)
+          _emit({ 0x24, 0x8F, 0x0C, 0x10 });    // and al,~(N|H|C) ; or al,C
+        else
+          _emit({ 0x24, 0x9F, 0x34, 0x10 });    // and al,~(N|H) ; xor al,C
+        _emit({ 0x88, 0x83 });                  // mov [rbx+f],al
+        _emit32(_offset(&_cpu._f));
+      }
+      else if (op == 0x18) {                    // JR n
+        _emit_store16(_offset(&_cpu._pc), ins.pc + 2 + static_cast<int8_t>(ins.b1));
+        branched = true;
+      }
+      else if ((op & 0xE7) == 0x20) {           // JR cc,n
+        _emit_branch(y - 4, ins.pc + 2 + static_cast<int8_t>(ins.b1), ins.pc + 2);
+        branched = true;
+      }
+      else if (op == 0xC3) {                    // JP nn
+        _emit_store16(_offset(&_cpu._pc), (ins.b2 << 8) | ins.b1);
+        branched = true;
+      }
+      else if ((op & 0xE7) == 0xC2) {           // JP cc,nn
+        _emit_branch(y, (ins.b2 << 8) | ins.b1, ins.pc + 3);
+        branched = true;
+      }
+      else if (op == 0xE9) {                    // JP (HL)
+        _emit_load16(_reg_offset(4), _reg_offset(5));
+        _emit({ 0x66, 0x89, 0x83 });            // mov [rbx+pc],ax
+        _emit32(_offset(&_cpu._pc));
+        branched = true;
+      }
+      else {
+        _emit_store16(_offset(&_cpu._pc), ins.pc);
+        _emit({ 0x48, 0x89, 0xDF });            // mov rdi,rbx
+        _emit({ 0xBE });                        // mov esi,imm32
+        _emit32(ins.op | (ins.b1 << 8) | (ins.b2 << 16));
+        _emit({ 0x48, 0xB8 });                  // mov rax,imm64
+        _emit64(reinterpret_cast<uint64_t>(&Jit::_call_handler));
+        _emit({ 0xFF, 0xD0 });                  // call rax
+      }
+    }
+
+    if (not branched) {
+      auto const& last = block.ins[len - 1];
+      _emit_store16(_offset(&_cpu._pc), last.pc + last.len);
+    }
+
+    // the handlers charged their own cycles, the block charges all of them
+    _emit({ 0xC7, 0x83 });                     // mov dword [rbx+cycles],imm32
+    _emit32(_offset(&_cpu._cycles));
+    _emit32(_ticks(block, len) - 1);
+
+    _emit({ 0x5B });                           // pop rbx
+    _emit({ 0xC3 });                           // ret
+  }
+
+  // ADD ADC SUB SBC AND XOR OR CP of A and register r, or of n if r is
+  // negative. x86 computes zero, half carry and carry just like the cpu.
+  void _emit_alu(int alu, int r, reg_t n)
+  {
+    _emit({ 0x0F, 0xB6, 0x83 });               // movzx eax,byte [rbx+a]
+    _emit32(_reg_offset(7));
+
+    if (alu == 1 or alu == 3) {
+      _emit({ 0x0F, 0xB6, 0x8B });             // movzx ecx,byte [rbx+f]
+      _emit32(_offset(&_cpu._f));
+      _emit({ 0x0F, 0xBA, 0xE1, 0x04 });       // bt ecx,4
+    }
+
+    // add adc sub sbb and xor or cmp
+    static uint8_t const ops[] = { 0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38 };
+    if (r < 0) {
+      _emit({ static_cast<uint8_t>(ops[alu] + 0x04), n }); // op al,imm8
+    }
+    else {
+      _emit({ static_cast<uint8_t>(ops[alu] + 0x02), 0x83 }); // op al,byte [rbx+r]
+      _emit32(_reg_offset(r));
+    }
+
+    if (alu != 7) {
+      _emit({ 0x88, 0x83 });                   // mov [rbx+a],al
+      _emit32(_reg_offset(7));
+    }
+
+    _emit({ 0x9F });                           // lahf
+
+    switch (alu) {
+    case 0: case 1: _emit_flags(0xB0, 0x0F, 0x00); break;
+    case 2: case 3:
+    case 7:         _emit_flags(0xB0, 0x0F, 0x40); break;
+    case 4:         _emit_flags(0x80, 0x0F, 0x20); break;
+    default:        _emit_flags(0x80, 0x0F, 0x00); break;
+    }
+  }
+
+  // F from the x86 flags lahf left in ah: the flags in computed (Z H C)
+  // as x86 has them, the bits in keep of the old F and the bits in set
+  void _emit_flags(reg_t computed, reg_t keep, reg_t set)
+  {
+    // ah: zero in bit 6, half carry (x86 auxiliary carry) in 4, carry in 0
+    _emit({ 0x0F, 0xB6, 0xCC });               // movzx ecx,ah
+    _emit({ 0x89, 0xCA });                     // mov edx,ecx
+    _emit({ 0x83, 0xE2, static_cast<uint8_t>((computed & 0xA0) >> 1) }); // and edx,Z|H
+    _emit({ 0x01, 0xD2 });                     // add edx,edx
+
+    if (computed & 0x10) {
+      _emit({ 0x83, 0xE1, 0x01 });             // and ecx,1
+      _emit({ 0xC1, 0xE1, 0x04 });             // shl ecx,4
+      _emit({ 0x09, 0xCA });                   // or edx,ecx
+    }
+
+    _emit({ 0x0F, 0xB6, 0x8B });               // movzx ecx,byte [rbx+f]
+    _emit32(_offset(&_cpu._f));
+    _emit({ 0x83, 0xE1, keep });               // and ecx,keep
+    _emit({ 0x09, 0xD1 });                     // or ecx,edx
+    if (set)
+      _emit({ 0x83, 0xC9, set });              // or ecx,set
+    _emit({ 0x88, 0x8B });                     // mov [rbx+f],cl
+    _emit32(_offset(&_cpu._f));
+  }
+
+  // pc becomes target if condition cc (NZ Z NC C) holds, next otherwise
+  void _emit_branch(int cc, wide_reg_t target, wide_reg_t next)
+  {
+    _emit({ 0xB9 });                           // mov ecx,next
+    _emit32(next);
+    _emit({ 0xBA });                           // mov edx,target
+    _emit32(target);
+    _emit({ 0xF6, 0x83 });                     // test byte [rbx+f],Z or C
+    _emit32(_offset(&_cpu._f));
+    _emit({ static_cast<uint8_t>(cc < 2 ? 0x80 : 0x10) });
+    _emit({ 0x0F, static_cast<uint8_t>(cc & 1 ? 0x45 : 0x44), 0xCA }); // cmovnz/cmovz ecx,edx
+    _emit({ 0x66, 0x89, 0x8B });               // mov [rbx+pc],cx
+    _emit32(_offset(&_cpu._pc));
+  }
+
+  // eax = high << 8 | low
+  void _emit_load16(int32_t high, int32_t low)
+  {
+    _emit({ 0x0F, 0xB6, 0x83 });               // movzx eax,byte [rbx+high]
+    _emit32(high);
+    _emit({ 0xC1, 0xE0, 0x08 });               // shl eax,8
+    _emit({ 0x0F, 0xB6, 0x8B });               // movzx ecx,byte [rbx+low]
+    _emit32(low);
+    _emit({ 0x09, 0xC8 });                     // or eax,ecx
+  }
+
+  void _emit_store8(int32_t offset, reg_t value)
+  {
+    _emit({ 0xC6, 0x83 });                     // mov byte [rbx+off],imm8
+    _emit32(offset);
+    _emit({ value });
+  }
+
+  void _emit_store16(int32_t offset, wide_reg_t value)
+  {
+    _emit({ 0x66, 0xC7, 0x83 });               // mov word [rbx+off],imm16
+    _emit32(offset);
+    _emit({ static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8) });
+  }
+
+  void _emit(std::initializer_list<uint8_t> bytes)
+  {
+    _code.insert(_code.end(), bytes);
+  }
+
+  void _emit32(uint32_t value)
+  {
+    for (int i = 0; i < 4; ++i)
+      _code.push_back(value >> (8 * i));
+  }
+
+  void _emit64(uint64_t value)
+  {
+    for (int i = 0; i < 8; ++i)
+      _code.push_back(value >> (8 * i));
+  }
+
+private:
+  Cpu&                             _cpu;
+
+  bool                             _enabled = false;
+  bool                             _verify  = false;
+  uint8_t*                         _arena   = nullptr;
+  size_t                           _used    = 0;
+  std::vector<uint8_t>             _code;
+  std::vector<BlockCache::Block*>  _compiled;
+  Stats                            _stats;
+};
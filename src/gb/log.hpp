@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Messages of the core, like the cartridge found or serial output. They
+// go to stdout unless another sink is set, none at all discards them. The
+// sink is shared by the whole process and may be called from the threads
+// running emulators, so it is set before any of them run.
+class Log
+{
+public:
+  typedef void (*sink_t)(char const* line, void* user);
+
+  static void sink(sink_t sink, void* user)
+  {
+    _target() = { sink, user };
+  }
+
+  // one line, printf formatted and without the newline
+  static void line(char const* format, ...)
+  {
+    auto const target = _target();
+    if (not target.sink)
+      return;
+
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    target.sink(text, target.user);
+  }
+
+private:
+  struct Target
+  {
+    sink_t sink;
+    void*  user;
+  };
+
+  static void _stdout(char const* line, void*)
+  {
+    printf("%s\n", line);
+  }
+
+  static Target& _target()
+  {
+    static Target target = { &Log::_stdout, nullptr };
+    return target;
+  }
+};
@@ -7,13 +7,30 @@ public:
 
   virtual reg_t read(wide_reg_t addr) const = 0;
   virtual void  write(wide_reg_t addr, reg_t value) = 0;
+  virtual int   rom_bank() const = 0;
+  virtual int   ram_bank() const { return 0; }
+  virtual void  save_state(StateWriter&) const {}
+  virtual void  load_state(StateReader&) {}
+  virtual bool  check_state(StateReader&) const { return true; }
   virtual std::string name() const = 0;
+
+  // the same registers, reading rom and ram of another cartridge
+  virtual std::unique_ptr<MBC> clone(RomView const& rom, mem_t& ram) const = 0;
+
+protected:
+  // reads of the banks stay within rom and ram
+  static bool _banks_exist(RomView const& rom, mem_t const& ram, int rom_bank, int ram_bank)
+  {
+    return
+      rom_bank >= 0 and (rom_bank + 1) * size_t(0x4000) <= rom.size and
+      ram_bank >= 0 and (ram_bank + 1) * size_t(0x2000) <= ram.size();
+  }
 };
 
 class MBCRomOnly : public MBC
 {
 public:
-  MBCRomOnly(mem_t const& rom)
+  MBCRomOnly(RomView const& rom)
     : _rom(rom)
   {
   }
@@ -27,13 +44,23 @@ public:
   {
   }
 
+  int rom_bank() const override
+  {
+    return 1;
+  }
+
   std::string name() const override
   {
     return "Rom";
   }
 
+  std::unique_ptr<MBC> clone(RomView const& rom, mem_t& /*ram*/) const override
+  {
+    return std::make_unique<MBCRomOnly>(rom);
+  }
+
 private:
-  mem_t const& _rom;
+  RomView const& _rom;
 };
 
 class MBC1 : public MBC
@@ -45,7 +72,7 @@ class MBC1 : public MBC
   };
 
 public:
-  MBC1(mem_t const& rom, mem_t& ram)
+  MBC1(RomView const& rom, mem_t& ram)
     : _mode(Mode::Rom)
     , _low(1)
     , _high(0)
@@ -87,11 +114,54 @@ public:
     }
   }
 
+  int rom_bank() const override
+  {
+    return _rom_bank_nr();
+  }
+
+  int ram_bank() const override
+  {
+    return _ram_bank_nr();
+  }
+
+  void save_state(StateWriter& state) const override
+  {
+    state.put(_mode);
+    state.put(_low);
+    state.put(_high);
+  }
+
+  void load_state(StateReader& state) override
+  {
+    state.get(_mode);
+    state.get(_low);
+    state.get(_high);
+  }
+
+  bool check_state(StateReader& state) const override
+  {
+    MBC1 mbc(_rom, _ram);
+    mbc.load_state(state);
+
+    return
+      (mbc._mode == Mode::Ram or mbc._mode == Mode::Rom) and
+      _banks_exist(_rom, _ram, mbc._rom_bank_nr(), mbc._ram_bank_nr());
+  }
+
   std::string name() const override
   {
     return "MBC1";
   }
 
+  std::unique_ptr<MBC> clone(RomView const& rom, mem_t& ram) const override
+  {
+    auto mbc = std::make_unique<MBC1>(rom, ram);
+    mbc->_mode = _mode;
+    mbc->_low  = _low;
+    mbc->_high = _high;
+    return mbc;
+  }
+
 private:
   int _rom_bank_nr() const
   {
@@ -131,14 +201,14 @@ private:
   int          _low;
   int          _high;
 
-  mem_t const& _rom;
-  mem_t&       _ram;
+  RomView const& _rom;
+  mem_t&         _ram;
 };
 
 class MBC2 : public MBC
 {
 public:
-  MBC2(mem_t const& rom, mem_t& ram)
+  MBC2(RomView const& rom, mem_t& ram)
     : _rom_bank_nr(1)
     , _rom(rom)
     , _ram(ram)
@@ -168,11 +238,46 @@ public:
     }
   }
 
+  int rom_bank() const override
+  {
+    return _rom_bank_nr;
+  }
+
+  int ram_bank() const override
+  {
+    return 1;
+  }
+
+  void save_state(StateWriter& state) const override
+  {
+    state.put(_rom_bank_nr);
+  }
+
+  void load_state(StateReader& state) override
+  {
+    state.get(_rom_bank_nr);
+  }
+
+  bool check_state(StateReader& state) const override
+  {
+    int rom_bank_nr = 0;
+    state.get(rom_bank_nr);
+
+    return _banks_exist(_rom, _ram, rom_bank_nr, 0);
+  }
+
   std::string name() const override
   {
     return "MBC2";
   }
 
+  std::unique_ptr<MBC> clone(RomView const& rom, mem_t& ram) const override
+  {
+    auto mbc = std::make_unique<MBC2>(rom, ram);
+    mbc->_rom_bank_nr = _rom_bank_nr;
+    return mbc;
+  }
+
 private:
   size_t _map_rom_addr(wide_reg_t addr) const
   {
@@ -190,15 +295,15 @@ private:
 private:
   int          _rom_bank_nr;
 
-  mem_t const& _rom;
-  mem_t&       _ram;
+  RomView const& _rom;
+  mem_t&         _ram;
 };
 
 class MBC5 : public MBC
 {
 public:
-  MBC5(mem_t const& rom, mem_t& ram)
-    : _ram_bank_nr(1)
+  MBC5(RomView const& rom, mem_t& ram)
+    : _ram_bank_nr(0)
     , _rom_bank_nr(0)
     , _rom(rom)
     , _ram(ram)
@@ -233,11 +338,51 @@ public:
     }
   }
 
+  int rom_bank() const override
+  {
+    return _rom_bank_nr;
+  }
+
+  int ram_bank() const override
+  {
+    return _ram_bank_nr;
+  }
+
+  void save_state(StateWriter& state) const override
+  {
+    state.put(_rom_bank_nr);
+    state.put(_ram_bank_nr);
+  }
+
+  void load_state(StateReader& state) override
+  {
+    state.get(_rom_bank_nr);
+    state.get(_ram_bank_nr);
+  }
+
+  bool check_state(StateReader& state) const override
+  {
+    int rom_bank_nr = 0;
+    int ram_bank_nr = 0;
+    state.get(rom_bank_nr);
+    state.get(ram_bank_nr);
+
+    return _banks_exist(_rom, _ram, rom_bank_nr, ram_bank_nr);
+  }
+
   std::string name() const override
   {
     return "MBC5";
   }
 
+  std::unique_ptr<MBC> clone(RomView const& rom, mem_t& ram) const override
+  {
+    auto mbc = std::make_unique<MBC5>(rom, ram);
+    mbc->_rom_bank_nr = _rom_bank_nr;
+    mbc->_ram_bank_nr = _ram_bank_nr;
+    return mbc;
+  }
+
 private:
   size_t _map_rom_addr(wide_reg_t addr) const
   {
@@ -256,6 +401,6 @@ private:
   int          _rom_bank_nr;
   int          _ram_bank_nr;
 
-  mem_t const& _rom;
-  mem_t&       _ram;
+  RomView const& _rom;
+  mem_t&         _ram;
 };
@@ -2,8 +2,10 @@
 
 #include "types.h"
 #include "cartridge.hpp"
+#include "debugger.hpp"
 
 #include <array>
+#include <utility>
 
 class MM
 {
@@ -13,55 +15,153 @@ public:
     return _cr.load(rom);
   }
 
+  Error insert_rom(RomImage::handle_t image)
+  {
+    return _cr.load(std::move(image));
+  }
+
   Error load_ram(mem_t const& ram)
   {
     return _cr.load_ram(ram);
   }
 
-  mem_t ram() const
+  mem_t const& ram() const
   {
     return _cr.ram();
   }
 
-  void power_on()
+  // a byte of cartridge ram by its offset in the whole ram, mapped or not
+  void poke_ram(size_t offset, reg_t value)
+  {
+    if (_cr.poke_ram(offset, value))
+      ++_page_versions[0xA0 + ((offset & 0x1FFF) >> 8)];
+  }
+
+  uint32_t take_dirty_ram_banks()
+  {
+    return _cr.take_dirty_ram_banks();
+  }
+
+  // Without the boot rom, io starts out the way the boot rom leaves it.
+  void power_on(bool boot_rom = true)
   {
     _cr.power_on();
 
-    _verified = false;
+    _boot_end = boot_rom ? 0x0100 : 0x0000;
+    _rom_bank = _cr.rom_bank();
+    ++_map_version;
 
     for (auto& mem : _mem)
       mem = 0x00;
+
+    if (not boot_rom) {
+      for (auto const& io : _post_boot_io)
+        _mem[io.first] = io.second;
+    }
   }
 
-  bool is_rom_verified() const
+  bool boot_rom_mapped() const
   {
-    return _verified;
+    return _boot_end != 0;
   }
 
-  void rom_verified()
+  // identifies what is mapped at addr: the boot rom, a rom bank or ram
+  uint16_t bank(wide_reg_t addr) const
   {
-    _verified = true;
+    if (addr < _boot_end)
+      return BANK_BOOT;
+
+    if (addr < 0x4000)
+      return 0;
+
+    if (addr < 0x8000)
+      return _rom_bank;
+
+    return BANK_RAM;
   }
 
-  reg_t read(wide_reg_t addr) const
+  uint64_t rom_hash() const
   {
-    reg_t value = 0;
+    return _cr.rom_hash();
+  }
 
-    if (addr >= 0xE000 and addr < 0xFE00) {
-      addr -= 0x2000; // adjust for mirror ram
-    }
+  uint64_t image_hash() const
+  {
+    return _cr.image_hash();
+  }
 
-    if (addr < 0x0100 and not _verified) {
-      value = _dmg[addr];
-    }
-    else if (addr < 0x8000 or (addr >= 0xA000 and addr <= 0xBFFF)) {
-      value = _cr.read(addr);
-    }
-    else {
-      value = _mem[addr];
-    }
+  // the rom and cartridge ram regions of _mem are never used
+  void save_state(StateWriter& state) const
+  {
+    state.put(_boot_end);
+    state.put(&_mem[0x8000], 0x2000);
+    state.put(&_mem[0xC000], 0x4000);
+    _cr.save_state(state);
+  }
 
-    return value;
+  // every cached decoding of ram and of the rom mapping becomes stale
+  void load_state(StateReader& state)
+  {
+    state.get(_boot_end);
+    state.get(&_mem[0x8000], 0x2000);
+    state.get(&_mem[0xC000], 0x4000);
+    _cr.load_state(state);
+
+    _rom_bank = _cr.rom_bank();
+    ++_map_version;
+    for (auto& version : _page_versions)
+      ++version;
+  }
+
+  // reads what load_state would, false for values it cannot restore
+  bool check_state(StateReader& state) const
+  {
+    wide_reg_t boot_end = 0;
+    state.get(boot_end);
+    state.skip(0x2000 + 0x4000);
+
+    return (boot_end == 0x0000 or boot_end == 0x0100) and _cr.check_state(state);
+  }
+
+  size_t patch_rom(wide_reg_t addr, reg_t value, int compare = -1)
+  {
+    ++_map_version;
+    return _cr.patch_rom(addr, value, compare);
+  }
+
+  void restore_rom()
+  {
+    ++_map_version;
+    _cr.restore_rom();
+  }
+
+  // bumped whenever the rom mapping may have changed
+  uint32_t map_version() const
+  {
+    return _map_version;
+  }
+
+  // bumped on every write into the 256 byte page containing addr
+  uint32_t page_version(wide_reg_t addr) const
+  {
+    return _page_versions[addr >> 8];
+  }
+
+  Debugger& debugger()
+  {
+    return _debugger;
+  }
+
+  // kept small so it gets inlined into the per cycle paths; everything
+  // that is not plain memory goes through _read_mapped. Read watchpoints
+  // are checked by the cpu for the same reason.
+  reg_t read(wide_reg_t addr) const
+  {
+    if (addr >= 0xFE00 or (addr >= 0x8000 and addr < 0xA000) or
+        (addr >= 0xC000 and addr < 0xE000))
+      return _mem[addr];
+
+    return _read_mapped(addr);
   }
 
   void write(wide_reg_t addr, reg_t value, bool internal = false)
@@ -85,22 +185,63 @@ public:
       }
     }
 
-    if (addr < 0x0100 and not _verified) {
-      // don't write
+    if (addr == 0xFF50 and value and _boot_end) { // boot rom off
+      _boot_end = 0;
+      ++_map_version;
     }
-    else if (addr < 0x8000 or (addr >= 0xA000 and addr <= 0xBFFF)) {
+
+    if (addr < 0x8000 or (addr >= 0xA000 and addr <= 0xBFFF)) {
       _cr.write(addr, value);
     }
     else {
       _mem[addr] = value;
     }
+
+    if (addr < 0x8000) {
+      _rom_bank = _cr.rom_bank();
+      ++_map_version;
+    }
+    else
+      ++_page_versions[addr >> 8];
+
+    if (not internal and (_debugger.watched_page(addr) & Debugger::WATCH_WRITE))
+      _debugger.access(Debugger::Hit::Kind::Write, addr, value);
   }
 
+  static const uint16_t BANK_BOOT = 0xFFFF;
+  static const uint16_t BANK_RAM  = 0xFFFE;
+
 private:
-  bool      _verified = false;
+  reg_t _read_mapped(wide_reg_t addr) const
+  {
+    reg_t value = 0;
+
+    if (addr >= 0xE000 and addr < 0xFE00) {
+      addr -= 0x2000; // adjust for mirror ram
+    }
+
+    if (addr < _boot_end) {
+      value = _dmg[addr];
+    }
+    else if (addr < 0x8000 or (addr >= 0xA000 and addr <= 0xBFFF)) {
+      value = _cr.read(addr);
+    }
+    else {
+      value = _mem[addr];
+    }
+
+    return value;
+  }
+
+  wide_reg_t _boot_end  = 0x0100; // the boot rom overlays the rom below
+  uint32_t  _map_version = 0;
+  uint16_t  _rom_bank    = 1; // cached, asking the mbc is a virtual call
+  std::array<uint32_t, 0x100> _page_versions = {{}};
   Cartridge _cr;
   mem_t     _rom      = mem_t();
-  mem_t     _mem      = mem_t(0xFFFF, static_cast<uint8_t>(0));
+  mem_t     _mem      = mem_t(0x10000, static_cast<uint8_t>(0));
+
+  Debugger  _debugger;
 
   std::array<reg_t, 0x100> const _dmg = {{
     0x31, 0xfe, 0xff, 0xaf, 0x21, 0xff, 0x9f, 0x32, 0xcb, 0x7c, 0x20, 0xfb,
@@ -126,4 +267,15 @@ private:
     0xf5, 0x06, 0x19, 0x78, 0x86, 0x23, 0x05, 0x20, 0xfb, 0x86, 0x20, 0xfe,
     0x3e, 0x01, 0xe0, 0x50
     }};
+
+  std::array<std::pair<wide_reg_t, reg_t>, 31> const _post_boot_io = {{
+    { 0xFF04, 0xAB }, { 0xFF05, 0x00 }, { 0xFF06, 0x00 }, { 0xFF07, 0x00 },
+    { 0xFF10, 0x80 }, { 0xFF11, 0xBF }, { 0xFF12, 0xF3 }, { 0xFF14, 0xBF },
+    { 0xFF16, 0x3F }, { 0xFF17, 0x00 }, { 0xFF19, 0xBF }, { 0xFF1A, 0x7F },
+    { 0xFF1B, 0xFF }, { 0xFF1C, 0x9F }, { 0xFF1E, 0xBF }, { 0xFF20, 0xFF },
+    { 0xFF21, 0x00 }, { 0xFF22, 0x00 }, { 0xFF23, 0xBF }, { 0xFF24, 0x77 },
+    { 0xFF25, 0xF3 }, { 0xFF26, 0xF1 }, { 0xFF40, 0x91 }, { 0xFF42, 0x00 },
+    { 0xFF43, 0x00 }, { 0xFF45, 0x00 }, { 0xFF47, 0xFC }, { 0xFF48, 0xFF },
+    { 0xFF49, 0xFF }, { 0xFF4A, 0x00 }, { 0xFF4B, 0x00 },
+    }};
 };
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+#include "gb.hpp"
+#include "hash.hpp"
+#include "state.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// The input of a run from power on, frame by frame, and a hash of every
+// frame's screen that a replay is checked against. The machine only sees
+// which buttons are held in a frame, so replaying that is exact. Only the
+// frames where the buttons change are stored. The cartridge ram and cheats
+// the run started with come along, a movie needs nothing but the rom.
+//
+// file: "YGBM", version, rom hash, fast boot, ram, cheats, changes
+// (frame, buttons), screen hashes; vectors are prefixed by their size
+class Movie
+{
+public:
+  struct Change
+  {
+    uint32_t frame;
+    reg_t    buttons;
+  };
+
+  // call after power on, cheats included
+  void start(GB const& gb, bool fast_boot)
+  {
+    _image_hash = gb.mm().image_hash();
+    _fast_boot  = fast_boot;
+    _ram        = gb.ram();
+
+    _cheats.clear();
+    for (auto const& code : gb.cheats().codes())
+      _cheats.push_back(code.text);
+
+    _changes.clear();
+    _screens.clear();
+  }
+
+  // call after each frame with the buttons it started with
+  void record(reg_t buttons, GB const& gb)
+  {
+    auto const frame = static_cast<uint32_t>(_screens.size());
+    if (_changes.empty() or _changes.back().buttons != buttons)
+      _changes.push_back({ frame, buttons });
+
+    _screens.push_back(screen_hash(gb));
+  }
+
+  size_t frames() const
+  {
+    return _screens.size();
+  }
+
+  // the way the recording started, the rom must be inserted already
+  Error power_on(GB& gb) const
+  {
+    if (gb.mm().image_hash() != _image_hash)
+      return Error(Error::Code::MovieInvalid);
+
+    gb.load_ram(_ram);
+    gb.power_on(_fast_boot);
+
+    gb.clear_cheats();
+    for (auto const& cheat : _cheats)
+      gb.add_cheat(cheat);
+
+    return Error::NoError();
+  }
+
+  // held during frame
+  reg_t buttons(size_t frame) const
+  {
+    auto const it = std::upper_bound(
+      _changes.begin(), _changes.end(), frame,
+      [] (size_t frame, Change const& change) { return frame < change.frame; });
+
+    return it == _changes.begin() ? 0 : std::prev(it)->buttons;
+  }
+
+  // hash of the screen at the end of frame
+  uint64_t screen(size_t frame) const
+  {
+    return _screens[frame];
+  }
+
+  // Powers gb on and runs all frames. mismatch is the first frame showing
+  // another screen, or frames().
+  Error play(GB& gb, size_t& mismatch) const
+  {
+    auto const error = power_on(gb);
+    if (error.is_set())
+      return error;
+
+    for (mismatch = 0; mismatch < _screens.size(); ++mismatch) {
+      gb.buttons(buttons(mismatch));
+      gb.run_frame();
+
+      if (screen_hash(gb) != _screens[mismatch])
+        break;
+    }
+
+    return Error::NoError();
+  }
+
+  static uint64_t screen_hash(GB const& gb)
+  {
+    auto const& screen = gb.screen();
+    return hash(screen.data(), screen.size());
+  }
+
+  Error save(std::string const& path) const
+  {
+    std::vector<uint8_t> data;
+    StateWriter file(data);
+
+    file.put(MAGIC);
+    file.put(VERSION);
+    file.put(_image_hash);
+    file.put(_fast_boot);
+
+    file.put(static_cast<uint32_t>(_ram.size()));
+    file.put(_ram.data(), _ram.size());
+
+    file.put(static_cast<uint32_t>(_cheats.size()));
+    for (auto const& cheat : _cheats) {
+      file.put(static_cast<uint32_t>(cheat.size()));
+      file.put(cheat.data(), cheat.size());
+    }
+
+    file.put(static_cast<uint32_t>(_changes.size()));
+    for (auto const& change : _changes) {
+      file.put(change.frame);
+      file.put(change.buttons);
+    }
+
+    file.put(static_cast<uint32_t>(_screens.size()));
+    file.put(_screens.data(), _screens.size() * sizeof(uint64_t));
+
+    std::ofstream s(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    s.write(reinterpret_cast<char const*>(data.data()), data.size());
+    if (not s)
+      return Error(Error::Code::FileNotAccessible);
+
+    return Error::NoError();
+  }
+
+  Error load(std::string const& path)
+  {
+    std::ifstream s(path, std::ios::in | std::ios::binary);
+    if (not s)
+      return Error(Error::Code::FileNotAccessible);
+
+    std::vector<uint8_t> const data(
+      (std::istreambuf_iterator<char>(s)),
+      std::istreambuf_iterator<char>());
+
+    StateReader file(data.data(), data.size());
+
+    char     magic[4] = {};
+    uint32_t version  = 0;
+    file.get(magic);
+    file.get(version);
+    if (file.failed() or
+        memcmp(magic, MAGIC, sizeof(magic)) != 0 or
+        version != VERSION)
+      return Error(Error::Code::MovieInvalid);
+
+    file.get(_image_hash);
+    file.get(_fast_boot);
+
+    _ram.resize(_count(file, 1));
+    file.get(_ram.data(), _ram.size());
+
+    _cheats.resize(_count(file, 4));
+    for (auto& cheat : _cheats) {
+      cheat.resize(_count(file, 1));
+      file.get(&cheat[0], cheat.size());
+    }
+
+    _changes.resize(_count(file, 5));
+    for (auto& change : _changes) {
+      file.get(change.frame);
+      file.get(change.buttons);
+    }
+
+    _screens.resize(_count(file, 8));
+    file.get(_screens.data(), _screens.size() * sizeof(uint64_t));
+
+    if (file.failed() or not file.at_end())
+      return Error(Error::Code::MovieInvalid);
+
+    return Error::NoError();
+  }
+
+private:
+  static constexpr char const MAGIC[4] = { 'Y', 'G', 'B', 'M' };
+  static constexpr uint32_t   VERSION  = 1;
+
+  // a size prefix, checked against what is left before anything is
+  // allocated for it
+  static uint32_t _count(StateReader& file, size_t element_size)
+  {
+    uint32_t count = 0;
+    file.get(count);
+    if (count > file.left() / element_size) {
+      file.fail();
+      return 0;
+    }
+
+    return count;
+  }
+
+  uint64_t                 _image_hash = 0;
+  bool                     _fast_boot  = false;
+  mem_t                    _ram;
+  std::vector<std::string> _cheats;
+  std::vector<Change>      _changes;
+  std::vector<uint64_t>    _screens;
+};
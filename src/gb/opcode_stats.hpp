@@ -0,0 +1,119 @@
+#pragma once
+
+#include "types.h"
+#include "opcodes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <stdio.h>
+
+// Executions and cycles per opcode, CB prefixed ones separately. While
+// counting, the backends execute one instruction at a time so that bulk
+// loops and translated blocks are broken down as well.
+class OpcodeStats
+{
+public:
+  struct Counter
+  {
+    uint64_t executed = 0;
+    uint64_t cycles   = 0;
+  };
+
+  bool enabled() const
+  {
+    return _enabled;
+  }
+
+  void enable(bool enable)
+  {
+    _enabled = enable;
+  }
+
+  void clear()
+  {
+    _base = {};
+    _cb   = {};
+  }
+
+  void count(reg_t op, reg_t b1, uint32_t cycles)
+  {
+    auto& counter = op == 0xCB ? _cb[b1] : _base[op];
+    ++counter.executed;
+    counter.cycles += cycles;
+  }
+
+  Counter const& base(reg_t op) const { return _base[op]; }
+  Counter const& cb(reg_t op) const { return _cb[op]; }
+
+  // opcodes that were executed, most cycles first
+  void print(FILE* f) const
+  {
+    auto const sorted = _sorted();
+
+    uint64_t total = 0;
+    for (auto const& entry : sorted)
+      total += entry.counter.cycles;
+
+    fprintf(f, "%-6s %-14s %14s %14s %7s\n", "op", "name", "executed", "cycles", "share");
+    for (auto const& entry : sorted) {
+      fprintf(
+        f, "%s%02x %-14s %14llu %14llu %6.2f%%\n",
+        entry.cb ? "cb " : "   ",
+        entry.op,
+        entry.cb ? Opcodes::name(0xCB, entry.op) : Opcodes::name(entry.op, 0),
+        static_cast<unsigned long long>(entry.counter.executed),
+        static_cast<unsigned long long>(entry.counter.cycles),
+        100.0 * entry.counter.cycles / total);
+    }
+  }
+
+  void print_json(FILE* f) const
+  {
+    auto const sorted = _sorted();
+
+    fprintf(f, "[\n");
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      auto const& entry = sorted[i];
+      fprintf(
+        f, "  {\"op\":\"%s%02x\",\"name\":\"%s\",\"executed\":%llu,\"cycles\":%llu}%s\n",
+        entry.cb ? "cb" : "",
+        entry.op,
+        entry.cb ? Opcodes::name(0xCB, entry.op) : Opcodes::name(entry.op, 0),
+        static_cast<unsigned long long>(entry.counter.executed),
+        static_cast<unsigned long long>(entry.counter.cycles),
+        i + 1 < sorted.size() ? "," : "");
+    }
+    fprintf(f, "]\n");
+  }
+
+private:
+  struct Entry
+  {
+    bool    cb;
+    reg_t   op;
+    Counter counter;
+  };
+
+  std::vector<Entry> _sorted() const
+  {
+    std::vector<Entry> entries;
+    for (size_t op = 0; op < 0x100; ++op) {
+      if (_base[op].executed)
+        entries.push_back({ false, static_cast<reg_t>(op), _base[op] });
+      if (_cb[op].executed)
+        entries.push_back({ true, static_cast<reg_t>(op), _cb[op] });
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [] (Entry const& l, Entry const& r) {
+      return l.counter.cycles > r.counter.cycles;
+    });
+
+    return entries;
+  }
+
+  bool                        _enabled = false;
+  std::array<Counter, 0x100>  _base    = {};
+  std::array<Counter, 0x100>  _cb      = {};
+};
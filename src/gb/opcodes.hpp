@@ -0,0 +1,337 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+
+// Static properties of the instruction set, shared by all cpu instances.
+// Cycles are the ones charged by the handlers in CP; CB prefixed
+// instructions are two bytes long and take 8 cycles, 16 with (HL).
+class Opcodes
+{
+public:
+  struct Info
+  {
+    char const* name;
+    reg_t       length;
+    reg_t       cycles;
+  };
+
+  static constexpr Info const& info(reg_t op)
+  {
+    return _info[op];
+  }
+
+  static char const* name(reg_t op, reg_t cb_op)
+  {
+    return op == 0xCB ? _cb_names[cb_op] : _info[op].name;
+  }
+
+  static reg_t length(reg_t op)
+  {
+    return _info[op].length;
+  }
+
+  static constexpr reg_t cycles(reg_t op, reg_t cb_op)
+  {
+    if (op == 0xCB)
+      return (cb_op & 0x07) == 0x06 ? 16 : 8;
+
+    return _info[op].cycles;
+  }
+
+private:
+  static constexpr std::array<Info, 0x100> _info = {{
+    { "NOP",        1,  4 }, // 0x00
+    { "LD BC,nn",   3, 12 }, // 0x01
+    { "LD (BC),A",  1,  8 }, // 0x02
+    { "INC BC",     1,  8 }, // 0x03
+    { "INC B",      1,  4 }, // 0x04
+    { "DEC B",      1,  4 }, // 0x05
+    { "LD B,n",     2,  8 }, // 0x06
+    { "RLCA",       1,  4 }, // 0x07
+    { "LD (nn),SP", 3, 20 }, // 0x08
+    { "ADD HL,BC",  1,  8 }, // 0x09
+    { "LD A,(BC)",  1,  8 }, // 0x0A
+    { "DEC BC",     1,  8 }, // 0x0B
+    { "INC C",      1,  4 }, // 0x0C
+    { "DEC C",      1,  4 }, // 0x0D
+    { "LD C,n",     2,  8 }, // 0x0E
+    { "RRCA",       1,  4 }, // 0x0F
+    { "STOP",       2,  4 }, // 0x10
+    { "LD DE,nn",   3, 12 }, // 0x11
+    { "LD (DE),A",  1,  8 }, // 0x12
+    { "INC DE",     1,  8 }, // 0x13
+    { "INC D",      1,  4 }, // 0x14
+    { "DEC D",      1,  4 }, // 0x15
+    { "LD D,n",     2,  8 }, // 0x16
+    { "RLA",        1,  4 }, // 0x17
+    { "JR n",       2,  8 }, // 0x18
+    { "ADD HL,DE",  1,  8 }, // 0x19
+    { "LD A,(DE)",  1,  8 }, // 0x1A
+    { "DEC DE",     1,  8 }, // 0x1B
+    { "INC E",      1,  4 }, // 0x1C
+    { "DEC E",      1,  4 }, // 0x1D
+    { "LD E,n",     2,  8 }, // 0x1E
+    { "RRA",        1,  4 }, // 0x1F
+    { "JR NZ,n",    2,  8 }, // 0x20
+    { "LD HL,nn",   3, 12 }, // 0x21
+    { "LD (HL+),A", 1,  8 }, // 0x22
+    { "INC HL",     1,  8 }, // 0x23
+    { "INC H",      1,  4 }, // 0x24
+    { "DEC H",      1,  4 }, // 0x25
+    { "LD H,n",     2,  8 }, // 0x26
+    { "DAA",        1,  4 }, // 0x27
+    { "JR Z,n",     2,  8 }, // 0x28
+    { "ADD HL,HL",  1,  8 }, // 0x29
+    { "LD A,(HL+)", 1,  8 }, // 0x2A
+    { "DEC HL",     1,  8 }, // 0x2B
+    { "INC L",      1,  4 }, // 0x2C
+    { "DEC L",      1,  4 }, // 0x2D
+    { "LD L,n",     2,  8 }, // 0x2E
+    { "CPL",        1,  4 }, // 0x2F
+    { "JR NC,n",    2,  8 }, // 0x30
+    { "LD SP,nn",   3, 12 }, // 0x31
+    { "LD (HL-),A", 1,  8 }, // 0x32
+    { "INC SP",     1,  8 }, // 0x33
+    { "INC (HL)",   1, 12 }, // 0x34
+    { "DEC (HL)",   1, 12 }, // 0x35
+    { "LD (HL),n",  2, 12 }, // 0x36
+    { "SCF",        1,  4 }, // 0x37
+    { "JR C,n",     2,  8 }, // 0x38
+    { "ADD HL,SP",  1,  8 }, // 0x39
+    { "LD A,(HL-)", 1,  8 }, // 0x3A
+    { "DEC SP",     1,  8 }, // 0x3B
+    { "INC A",      1,  4 }, // 0x3C
+    { "DEC A",      1,  4 }, // 0x3D
+    { "LD A,n",     2,  8 }, // 0x3E
+    { "CCF",        1,  4 }, // 0x3F
+    { "LD B,B",     1,  4 }, // 0x40
+    { "LD B,C",     1,  4 }, // 0x41
+    { "LD B,D",     1,  4 }, // 0x42
+    { "LD B,E",     1,  4 }, // 0x43
+    { "LD B,H",     1,  4 }, // 0x44
+    { "LD B,L",     1,  4 }, // 0x45
+    { "LD B,(HL)",  1,  8 }, // 0x46
+    { "LD B,A",     1,  4 }, // 0x47
+    { "LD C,B",     1,  4 }, // 0x48
+    { "LD C,C",     1,  4 }, // 0x49
+    { "LD C,D",     1,  4 }, // 0x4A
+    { "LD C,E",     1,  4 }, // 0x4B
+    { "LD C,H",     1,  4 }, // 0x4C
+    { "LD C,L",     1,  4 }, // 0x4D
+    { "LD C,(HL)",  1,  8 }, // 0x4E
+    { "LD C,A",     1,  4 }, // 0x4F
+    { "LD D,B",     1,  4 }, // 0x50
+    { "LD D,C",     1,  4 }, // 0x51
+    { "LD D,D",     1,  4 }, // 0x52
+    { "LD D,E",     1,  4 }, // 0x53
+    { "LD D,H",     1,  4 }, // 0x54
+    { "LD D,L",     1,  4 }, // 0x55
+    { "LD D,(HL)",  1,  8 }, // 0x56
+    { "LD D,A",     1,  4 }, // 0x57
+    { "LD E,B",     1,  4 }, // 0x58
+    { "LD E,C",     1,  4 }, // 0x59
+    { "LD E,D",     1,  4 }, // 0x5A
+    { "LD E,E",     1,  4 }, // 0x5B
+    { "LD E,H",     1,  4 }, // 0x5C
+    { "LD E,L",     1,  4 }, // 0x5D
+    { "LD E,(HL)",  1,  8 }, // 0x5E
+    { "LD E,A",     1,  4 }, // 0x5F
+    { "LD H,B",     1,  4 }, // 0x60
+    { "LD H,C",     1,  4 }, // 0x61
+    { "LD H,D",     1,  4 }, // 0x62
+    { "LD H,E",     1,  4 }, // 0x63
+    { "LD H,H",     1,  4 }, // 0x64
+    { "LD H,l",     1,  4 }, // 0x65
+    { "LD H,(HL)",  1,  8 }, // 0x66
+    { "LD H,A",     1,  4 }, // 0x67
+    { "LD L,B",     1,  4 }, // 0x68
+    { "LD L,C",     1,  4 }, // 0x69
+    { "LD L,D",     1,  4 }, // 0x6A
+    { "LD L,E",     1,  4 }, // 0x6B
+    { "LD L,H",     1,  4 }, // 0x6C
+    { "LD L,L",     1,  4 }, // 0x6D
+    { "LD L,(HL)",  1,  8 }, // 0x6E
+    { "LD L,A",     1,  4 }, // 0x6F
+    { "LD (HL),B",  1,  8 }, // 0x70
+    { "LD (HL),C",  1,  8 }, // 0x71
+    { "LD (HL),D",  1,  8 }, // 0x72
+    { "LD (HL),E",  1,  8 }, // 0x73
+    { "LD (HL),H",  1,  8 }, // 0x74
+    { "LD (HL),L",  1,  8 }, // 0x75
+    { "HALT",       1,  4 }, // 0x76
+    { "LD (HL),A",  1,  8 }, // 0x77
+    { "LD A,B",     1,  4 }, // 0x78
+    { "LD A,C",     1,  4 }, // 0x79
+    { "LD A,D",     1,  4 }, // 0x7A
+    { "LD A,E",     1,  4 }, // 0x7B
+    { "LD A,H",     1,  4 }, // 0x7C
+    { "LD A,L",     1,  4 }, // 0x7D
+    { "LD A,(HL)",  1,  8 }, // 0x7E
+    { "LD A,A",     1,  4 }, // 0x7F
+    { "ADD A,B",    1,  4 }, // 0x80
+    { "ADD A,C",    1,  4 }, // 0x81
+    { "ADD A,D",    1,  4 }, // 0x82
+    { "ADD A,E",    1,  4 }, // 0x83
+    { "ADD A,H",    1,  4 }, // 0x84
+    { "ADD A,L",    1,  4 }, // 0x85
+    { "ADD A,(HL)", 1,  8 }, // 0x86
+    { "ADD A,A",    1,  4 }, // 0x87
+    { "ADC A,B",    1,  4 }, // 0x88
+    { "ADC A,C",    1,  4 }, // 0x89
+    { "ADC A,D",    1,  4 }, // 0x8A
+    { "ADC A,E",    1,  4 }, // 0x8B
+    { "ADC A,H",    1,  4 }, // 0x8C
+    { "ADC A,L",    1,  4 }, // 0x8D
+    { "ADC A,(HL)", 1,  8 }, // 0x8E
+    { "ADC A,A",    1,  4 }, // 0x8F
+    { "SUB B",      1,  4 }, // 0x90
+    { "SUB C",      1,  4 }, // 0x91
+    { "SUB D",      1,  4 }, // 0x92
+    { "SUB E",      1,  4 }, // 0x93
+    { "SUB H",      1,  4 }, // 0x94
+    { "SUB L",      1,  4 }, // 0x95
+    { "SUB (HL)",   1,  8 }, // 0x96
+    { "SUB A",      1,  4 }, // 0x97
+    { "SBC A,B",    1,  4 }, // 0x98
+    { "SBC A,C",    1,  4 }, // 0x99
+    { "SBC A,D",    1,  4 }, // 0x9A
+    { "SBC A,E",    1,  4 }, // 0x9B
+    { "SBC A,H",    1,  4 }, // 0x9C
+    { "SBC A,L",    1,  4 }, // 0x9D
+    { "SBC A,(HL)", 1,  8 }, // 0x9E
+    { "SBC A,A",    1,  4 }, // 0x9F
+    { "AND B",      1,  4 }, // 0xA0
+    { "AND C",      1,  4 }, // 0xA1
+    { "AND D",      1,  4 }, // 0xA2
+    { "AND E",      1,  4 }, // 0xA3
+    { "AND H",      1,  4 }, // 0xA4
+    { "AND L",      1,  4 }, // 0xA5
+    { "AND (HL)",   1,  8 }, // 0xA6
+    { "AND A",      1,  4 }, // 0xA7
+    { "XOR B",      1,  4 }, // 0xA8
+    { "XOR C",      1,  4 }, // 0xA9
+    { "XOR D",      1,  4 }, // 0xAA
+    { "XOR E",      1,  4 }, // 0xAB
+    { "XOR H",      1,  4 }, // 0xAC
+    { "XOR L",      1,  4 }, // 0xAD
+    { "XOR (HL)",   1,  8 }, // 0xAE
+    { "XOR A",      1,  4 }, // 0xAF
+    { "OR B",       1,  4 }, // 0xB0
+    { "OR C",       1,  4 }, // 0xB1
+    { "OR D",       1,  4 }, // 0xB2
+    { "OR E",       1,  4 }, // 0xB3
+    { "OR H",       1,  4 }, // 0xB4
+    { "OR L",       1,  4 }, // 0xB5
+    { "OR (HL)",    1,  8 }, // 0xB6
+    { "OR A",       1,  4 }, // 0xB7
+    { "CP B",       1,  4 }, // 0xB8
+    { "CP C",       1,  4 }, // 0xB9
+    { "CP D",       1,  4 }, // 0xBA
+    { "CP E",       1,  4 }, // 0xBB
+    { "CP H",       1,  4 }, // 0xBC
+    { "CP L",       1,  4 }, // 0xBD
+    { "CP (HL)",    1,  8 }, // 0xBE
+    { "CP A",       1,  4 }, // 0xBF
+    { "RET NZ",     1, 12 }, // 0xC0
+    { "POP BC",     1, 12 }, // 0xC1
+    { "JP NZ,nn",   3, 12 }, // 0xC2
+    { "JP nn",      3, 12 }, // 0xC3
+    { "CALL NZ,nn", 3, 12 }, // 0xC4
+    { "PUSH BC",    1, 16 }, // 0xC5
+    { "ADD A,#",    2,  8 }, // 0xC6
+    { "RST 00H",    1, 32 }, // 0xC7
+    { "RET Z",      1, 12 }, // 0xC8
+    { "RET",        1,  8 }, // 0xC9
+    { "JP Z,nn",    3, 12 }, // 0xCA
+    { "PREF",       2,  0 }, // 0xCB
+    { "CALL Z,nn",  3, 12 }, // 0xCC
+    { "CALL nn",    3, 12 }, // 0xCD
+    { "ADC A,#",    2,  8 }, // 0xCE
+    { "RST 08H",    1, 32 }, // 0xCF
+    { "RET NC",     1, 12 }, // 0xD0
+    { "POP DE",     1, 12 }, // 0xD1
+    { "JP NC,nn",   3, 12 }, // 0xD2
+    { "---",        1,  0 }, // 0xD3
+    { "CALL NC,nn", 3, 12 }, // 0xD4
+    { "PUSH DE",    1, 16 }, // 0xD5
+    { "SUB #",      2,  8 }, // 0xD6
+    { "RST 10H",    1, 32 }, // 0xD7
+    { "RET C",      1, 12 }, // 0xD8
+    { "RETI",       1,  8 }, // 0xD9
+    { "JP C,nn",    3, 12 }, // 0xDA
+    { "---",        1,  0 }, // 0xDB
+    { "CALL C,nn",  3, 12 }, // 0xDC
+    { "---",        1,  0 }, // 0xDD
+    { "SBC A,#",    2,  4 }, // 0xDE
+    { "RST 18H",    1, 32 }, // 0xDF
+    { "LD (n),A",   2, 12 }, // 0xE0
+    { "POP HL",     1, 12 }, // 0xE1
+    { "LD (C),A",   1,  8 }, // 0xE2
+    { "---",        1,  0 }, // 0xE3
+    { "---",        1,  0 }, // 0xE4
+    { "PUSH HL",    1, 16 }, // 0xE5
+    { "AND #",      2,  8 }, // 0xE6
+    { "RST 20H",    1, 32 }, // 0xE7
+    { "ADD SP,#",   2, 16 }, // 0xE8
+    { "JP (HL)",    1,  4 }, // 0xE9
+    { "LD (nn),A",  3,  8 }, // 0xEA
+    { "---",        1,  0 }, // 0xEB
+    { "---",        1,  0 }, // 0xEC
+    { "---",        1,  0 }, // 0xED
+    { "XOR #",      2,  8 }, // 0xEE
+    { "RST 28H",    1, 32 }, // 0xEF
+    { "LD A,(n)",   2, 12 }, // 0xF0
+    { "POP AF",     1, 12 }, // 0xF1
+    { "LD A,(C)",   1,  8 }, // 0xF2
+    { "DI",         1,  4 }, // 0xF3
+    { "---",        1,  0 }, // 0xF4
+    { "PUSH AF",    1, 16 }, // 0xF5
+    { "OR #",       2,  8 }, // 0xF6
+    { "RST 30H",    1, 32 }, // 0xF7
+    { "LD HL,SP+n", 2, 12 }, // 0xF8
+    { "LD SP,HL",   1,  8 }, // 0xF9
+    { "LD A,(nn)",  3, 16 }, // 0xFA
+    { "EI",         1,  4 }, // 0xFB
+    { "---",        1,  0 }, // 0xFC
+    { "---",        1,  0 }, // 0xFD
+    { "CP #",       2,  8 }, // 0xFE
+    { "RST 38H",    1, 32 }, // 0xFF
+  }};
+
+  static constexpr std::array<char const*, 0x100> _cb_names = {{
+    "RLC B",      "RLC C",      "RLC D",      "RLC E",      "RLC H",      "RLC L",      "RLC (HL)",   "RLC A", // 0x00
+    "RRC B",      "RRC C",      "RRC D",      "RRC E",      "RRC H",      "RRC L",      "RRC (HL)",   "RRC A", // 0x08
+    "RL B",       "RL C",       "RL D",       "RL E",       "RL H",       "RL L",       "RL (HL)",    "RL A", // 0x10
+    "RR B",       "RR C",       "RR D",       "RR E",       "RR H",       "RR L",       "RR (HL)",    "RR A", // 0x18
+    "SLA B",      "SLA C",      "SLA D",      "SLA E",      "SLA H",      "SLA L",      "SLA (HL)",   "SLA A", // 0x20
+    "SRA B",      "SRA C",      "SRA D",      "SRA E",      "SRA H",      "SRA L",      "SRA (HL)",   "SRA A", // 0x28
+    "SWAP B",     "SWAP C",     "SWAP D",     "SWAP E",     "SWAP H",     "SWAP L",     "SWAP (HL)",  "SWAP A", // 0x30
+    "SRL B",      "SRL C",      "SRL D",      "SRL E",      "SRL H",      "SRL L",      "SRL (HL)",   "SRL A", // 0x38
+    "BIT 0,B",    "BIT 0,C",    "BIT 0,D",    "BIT 0,E",    "BIT 0,H",    "BIT 0,L",    "BIT 0,(HL)", "BIT 0,A", // 0x40
+    "BIT 1,B",    "BIT 1,C",    "BIT 1,D",    "BIT 1,E",    "BIT 1,H",    "BIT 1,L",    "BIT 1,(HL)", "BIT 1,A", // 0x48
+    "BIT 2,B",    "BIT 2,C",    "BIT 2,D",    "BIT 2,E",    "BIT 2,H",    "BIT 2,L",    "BIT 2,(HL)", "BIT 2,A", // 0x50
+    "BIT 3,B",    "BIT 3,C",    "BIT 3,D",    "BIT 3,E",    "BIT 3,H",    "BIT 3,L",    "BIT 3,(HL)", "BIT 3,A", // 0x58
+    "BIT 4,B",    "BIT 4,C",    "BIT 4,D",    "BIT 4,E",    "BIT 4,H",    "BIT 4,L",    "BIT 4,(HL)", "BIT 4,A", // 0x60
+    "BIT 5,B",    "BIT 5,C",    "BIT 5,D",    "BIT 5,E",    "BIT 5,H",    "BIT 5,L",    "BIT 5,(HL)", "BIT 5,A", // 0x68
+    "BIT 6,B",    "BIT 6,C",    "BIT 6,D",    "BIT 6,E",    "BIT 6,H",    "BIT 6,L",    "BIT 6,(HL)", "BIT 6,A", // 0x70
+    "BIT 7,B",    "BIT 7,C",    "BIT 7,D",    "BIT 7,E",    "BIT 7,H",    "BIT 7,L",    "BIT 7,(HL)", "BIT 7,A", // 0x78
+    "RES 0,B",    "RES 0,C",    "RES 0,D",    "RES 0,E",    "RES 0,H",    "RES 0,L",    "RES 0,(HL)", "RES 0,A", // 0x80
+    "RES 1,B",    "RES 1,C",    "RES 1,D",    "RES 1,E",    "RES 1,H",    "RES 1,L",    "RES 1,(HL)", "RES 1,A", // 0x88
+    "RES 2,B",    "RES 2,C",    "RES 2,D",    "RES 2,E",    "RES 2,H",    "RES 2,L",    "RES 2,(HL)", "RES 2,A", // 0x90
+    "RES 3,B",    "RES 3,C",    "RES 3,D",    "RES 3,E",    "RES 3,H",    "RES 3,L",    "RES 3,(HL)", "RES 3,A", // 0x98
+    "RES 4,B",    "RES 4,C",    "RES 4,D",    "RES 4,E",    "RES 4,H",    "RES 4,L",    "RES 4,(HL)", "RES 4,A", // 0xA0
+    "RES 5,B",    "RES 5,C",    "RES 5,D",    "RES 5,E",    "RES 5,H",    "RES 5,L",    "RES 5,(HL)", "RES 5,A", // 0xA8
+    "RES 6,B",    "RES 6,C",    "RES 6,D",    "RES 6,E",    "RES 6,H",    "RES 6,L",    "RES 6,(HL)", "RES 6,A", // 0xB0
+    "RES 7,B",    "RES 7,C",    "RES 7,D",    "RES 7,E",    "RES 7,H",    "RES 7,L",    "RES 7,(HL)", "RES 7,A", // 0xB8
+    "SET 0,B",    "SET 0,C",    "SET 0,D",    "SET 0,E",    "SET 0,H",    "SET 0,L",    "SET 0,(HL)", "SET 0,A", // 0xC0
+    "SET 1,B",    "SET 1,C",    "SET 1,D",    "SET 1,E",    "SET 1,H",    "SET 1,L",    "SET 1,(HL)", "SET 1,A", // 0xC8
+    "SET 2,B",    "SET 2,C",    "SET 2,D",    "SET 2,E",    "SET 2,H",    "SET 2,L",    "SET 2,(HL)", "SET 2,A", // 0xD0
+    "SET 3,B",    "SET 3,C",    "SET 3,D",    "SET 3,E",    "SET 3,H",    "SET 3,L",    "SET 3,(HL)", "SET 3,A", // 0xD8
+    "SET 4,B",    "SET 4,C",    "SET 4,D",    "SET 4,E",    "SET 4,H",    "SET 4,L",    "SET 4,(HL)", "SET 4,A", // 0xE0
+    "SET 5,B",    "SET 5,C",    "SET 5,D",    "SET 5,E",    "SET 5,H",    "SET 5,L",    "SET 5,(HL)", "SET 5,A", // 0xE8
+    "SET 6,B",    "SET 6,C",    "SET 6,D",    "SET 6,E",    "SET 6,H",    "SET 6,L",    "SET 6,(HL)", "SET 6,A", // 0xF0
+    "SET 7,B",    "SET 7,C",    "SET 7,D",    "SET 7,E",    "SET 7,H",    "SET 7,L",    "SET 7,(HL)", "SET 7,A", // 0xF8
+  }};
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads that run one function over a range of indices, the calling
+// thread included. Every thread starts with an equal slice of the range
+// and takes indices from its front; a thread that runs out steals the back
+// half of another slice, so a few slow indices do not hold up the rest.
+// A slice is a single atomic (begin, end) pair that owner and thieves both
+// change with compare and swap.
+class Pool
+{
+public:
+  // 0 threads is one per core
+  Pool(size_t threads = 0)
+    : _slices(std::max<size_t>(threads ? threads : std::thread::hardware_concurrency(), 1))
+  {
+    for (size_t id = 1; id < _slices.size(); ++id)
+      _threads.emplace_back([this, id] { _run(id); });
+  }
+
+  ~Pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+
+    for (auto& thread : _threads)
+      thread.join();
+  }
+
+  Pool(Pool const&) = delete;
+  Pool& operator=(Pool const&) = delete;
+
+  size_t threads() const
+  {
+    return _slices.size();
+  }
+
+  // calls fn(i) once for every i below count and returns when all are done
+  void run(size_t count, std::function<void(size_t)> const& fn)
+  {
+    auto const threads = _slices.size();
+    for (size_t id = 0; id < threads; ++id)
+      _slices[id].range.store(_pack(count * id / threads, count * (id + 1) / threads));
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _fn      = &fn;
+      _running = threads - 1;
+      ++_generation;
+    }
+    _wake.notify_all();
+
+    _work(0, fn);
+
+    // a thread only leaves _work when no slice has anything left and it
+    // holds nothing, so once all left every index ran
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _running == 0; });
+    _fn = nullptr;
+  }
+
+private:
+  struct alignas(64) Slice
+  {
+    std::atomic<uint64_t> range = { 0 };
+  };
+
+  static uint64_t _pack(uint64_t begin, uint64_t end)
+  {
+    return begin | (end << 32);
+  }
+
+  static uint32_t _begin(uint64_t range) { return range & 0xFFFFFFFF; }
+  static uint32_t _end(uint64_t range) { return range >> 32; }
+
+  void _run(size_t id)
+  {
+    uint64_t seen = 0;
+    for (;;) {
+      std::function<void(size_t)> const* fn = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [this, seen] { return _stop or _generation != seen; });
+        if (_stop)
+          return;
+
+        seen = _generation;
+        fn   = _fn;
+      }
+
+      _work(id, *fn);
+
+      bool last = false;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        last = --_running == 0;
+      }
+      if (last)
+        _done.notify_one();
+    }
+  }
+
+  void _work(size_t id, std::function<void(size_t)> const& fn)
+  {
+    auto& own = _slices[id].range;
+    for (;;) {
+      auto range = own.load();
+      while (_begin(range) < _end(range)) {
+        if (not own.compare_exchange_weak(range, _pack(_begin(range) + 1, _end(range))))
+          continue;
+
+        fn(_begin(range));
+        range = own.load();
+      }
+
+      if (not _steal(id))
+        return;
+    }
+  }
+
+  bool _steal(size_t id)
+  {
+    auto const threads = _slices.size();
+    for (size_t n = 1; n < threads; ++n) {
+      auto& victim = _slices[(id + n) % threads].range;
+      auto range = victim.load();
+      while (_begin(range) < _end(range)) {
+        auto const half = (_end(range) - _begin(range) + 1) / 2;
+        auto const from = _end(range) - half;
+        if (victim.compare_exchange_weak(range, _pack(_begin(range), from))) {
+          _slices[id].range.store(_pack(from, from + half));
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  std::vector<Slice>        _slices;
+  std::vector<std::thread>  _threads;
+
+  std::mutex                _mutex;
+  std::condition_variable   _wake;
+  std::condition_variable   _done;
+  bool                      _stop       = false;
+  uint64_t                  _generation = 0;
+  size_t                    _running    = 0;
+  std::function<void(size_t)> const* _fn = nullptr;
+};
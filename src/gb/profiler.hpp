@@ -0,0 +1,226 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+#include "mm.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Symbols from an RGBDS .sym file ("BB:AAAA Name", ';' starts a comment).
+// Local labels ("Function.loop") count towards their function.
+class Symbols
+{
+public:
+  Error load(std::string const& path)
+  {
+    std::ifstream s(path);
+    if (not s)
+      return Error(Error::Code::FileNotAccessible);
+
+    std::string line;
+    while (std::getline(s, line)) {
+      line = line.substr(0, line.find(';'));
+
+      auto const colon = line.find(':');
+      auto const space = line.find(' ', colon);
+      if (colon == std::string::npos or space == std::string::npos)
+        continue;
+
+      char* end = nullptr;
+      auto const bank = strtoul(line.c_str(), &end, 16);
+      if (end != line.c_str() + colon)
+        continue;
+
+      auto const addr = strtoul(line.c_str() + colon + 1, &end, 16);
+      if (end != line.c_str() + space)
+        continue;
+
+      auto name = line.substr(space + 1);
+      name = name.substr(0, name.find_first_of(". \r\t"));
+      if (name.empty())
+        continue;
+
+      _functions[_key(bank, addr)] = name;
+    }
+
+    return Error::NoError();
+  }
+
+  bool empty() const
+  {
+    return _functions.empty();
+  }
+
+  // the function containing pc, nullptr if there is no symbol before it
+  std::string const* find(uint16_t bank, wide_reg_t pc) const
+  {
+    // fixed rom and ram symbols are listed in bank 0
+    if (pc < 0x4000 or pc >= 0x8000 or bank == MM::BANK_BOOT)
+      bank = 0;
+
+    auto it = _functions.upper_bound(_key(bank, pc));
+    if (it == _functions.begin())
+      return nullptr;
+
+    --it;
+    if ((it->first >> 16) != bank or _region(it->first) != _region(pc))
+      return nullptr;
+
+    return &it->second;
+  }
+
+private:
+  static uint32_t _key(uint32_t bank, uint32_t addr)
+  {
+    return (bank << 16) | (addr & 0xFFFF);
+  }
+
+  static int _region(uint32_t addr)
+  {
+    addr &= 0xFFFF;
+    return addr < 0x4000 ? 0 : addr < 0x8000 ? 1 : 2;
+  }
+
+  std::map<uint32_t, std::string> _functions;
+};
+
+// Counts the cycles spent per (bank, pc).
+class Profiler
+{
+public:
+  enum class Format {
+    Folded, // "bank;function cycles" per line, input for flamegraph tools
+    Flat,   // cycles, share and function sorted by cycles
+  };
+
+  bool enabled() const
+  {
+    return _enabled;
+  }
+
+  void enable(bool enable)
+  {
+    _enabled = enable;
+  }
+
+  void clear()
+  {
+    _banks.clear();
+    _last   = nullptr;
+    _halted = 0;
+  }
+
+  void count(uint16_t bank, wide_reg_t pc, uint32_t cycles)
+  {
+    if (not _last or bank != _last_bank) {
+      auto& counts = _banks[bank];
+      if (counts.empty())
+        counts.resize(0x10000);
+
+      _last      = counts.data();
+      _last_bank = bank;
+    }
+
+    _last[pc] += cycles;
+  }
+
+  void count_halted()
+  {
+    ++_halted;
+  }
+
+  // Totals per function, or per address where no symbol covers it,
+  // sorted by cycles.
+  std::vector<std::pair<std::string, uint64_t>> functions(Symbols const& symbols) const
+  {
+    std::unordered_map<std::string, uint64_t> totals;
+
+    for (auto const& entry : _banks) {
+      auto const bank = entry.first;
+      auto const& counts = entry.second;
+
+      for (uint32_t pc = 0; pc < counts.size(); ++pc) {
+        if (counts[pc] == 0)
+          continue;
+
+        auto const* name = symbols.find(bank, pc);
+        totals[_bank_name(bank) + ";" + (name ? *name : _address(pc))] += counts[pc];
+      }
+    }
+
+    if (_halted)
+      totals["halted"] += _halted;
+
+    std::vector<std::pair<std::string, uint64_t>> sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(), [] (auto const& l, auto const& r) {
+      return l.second != r.second ? l.second > r.second : l.first < r.first;
+    });
+
+    return sorted;
+  }
+
+  Error write(std::string const& path, Symbols const& symbols, Format format) const
+  {
+    auto* f = fopen(path.c_str(), "w");
+    if (not f)
+      return Error(Error::Code::FileNotAccessible);
+
+    auto const functions = this->functions(symbols);
+
+    uint64_t total = 0;
+    for (auto const& fn : functions)
+      total += fn.second;
+
+    for (auto const& fn : functions) {
+      if (format == Format::Folded)
+        fprintf(f, "%s %llu\n", fn.first.c_str(), static_cast<unsigned long long>(fn.second));
+      else
+        fprintf(
+          f, "%14llu %6.2f%% %s\n",
+          static_cast<unsigned long long>(fn.second),
+          100.0 * fn.second / total,
+          fn.first.c_str());
+    }
+
+    if (fclose(f) != 0)
+      return Error(Error::Code::FileNotAccessible);
+
+    return Error::NoError();
+  }
+
+private:
+  static std::string _bank_name(uint16_t bank)
+  {
+    char text[8];
+    if (bank == MM::BANK_BOOT)
+      return "boot";
+    if (bank == MM::BANK_RAM)
+      return "ram";
+
+    snprintf(text, sizeof(text), "rom%02x", bank);
+    return text;
+  }
+
+  static std::string _address(wide_reg_t pc)
+  {
+    char text[8];
+    snprintf(text, sizeof(text), "%04x", pc);
+    return text;
+  }
+
+  bool      _enabled   = false;
+  uint64_t* _last      = nullptr;
+  uint16_t  _last_bank = 0;
+  uint64_t  _halted    = 0;
+
+  std::unordered_map<uint16_t, std::vector<uint64_t>> _banks;
+};
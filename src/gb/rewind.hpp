@@ -0,0 +1,199 @@
+#pragma once
+
+#include "types.h"
+#include "gb.hpp"
+
+#include <deque>
+#include <vector>
+
+#include <string.h>
+
+// History of per frame save states for stepping backwards. Only the newest
+// state is kept whole; every frame stores its difference to the one before
+// it, xored word by word and with the zero runs squeezed out. Since xor
+// undoes itself, stepping back applies the newest difference to the whole
+// state, so no keyframes are needed. The oldest frames are dropped to stay
+// within the memory budget.
+//
+// difference: (zero words, literal words, literal words as they are)...
+// with the counts as LEB128
+class Rewind
+{
+public:
+  static const size_t DEFAULT_BUDGET = 32 << 20;
+
+  Rewind(size_t budget = DEFAULT_BUDGET)
+    : _budget(budget)
+  {}
+
+  void budget(size_t budget)
+  {
+    _budget = budget;
+    _evict();
+  }
+
+  void clear()
+  {
+    _frames.clear();
+    _newest.clear();
+    _bytes = 0;
+  }
+
+  size_t frames() const
+  {
+    return _frames.size();
+  }
+
+  // memory held by the differences
+  size_t bytes() const
+  {
+    return _bytes;
+  }
+
+  // call once per frame
+  void push(GB const& gb)
+  {
+    gb.save_state(_state);
+    _size = _state.size();
+    _state.resize(_words(_size) * 8);
+
+    if (_newest.size() != _state.size()) {
+      clear();
+      _newest.swap(_state);
+      _frames.emplace_back();
+      return;
+    }
+
+    auto diff = _recycle();
+    _encode(_state, _newest, diff);
+    _bytes += diff.size();
+    _frames.push_back(std::move(diff));
+
+    _newest.swap(_state);
+    _evict();
+  }
+
+  // restores the frame before the newest and drops the newest; false when
+  // there is nothing left to go back to
+  bool pop(GB& gb)
+  {
+    if (_frames.size() < 2)
+      return false;
+
+    _decode(_frames.back(), _newest);
+    _bytes -= _frames.back().size();
+    _spare.swap(_frames.back());
+    _frames.pop_back();
+
+    _state.assign(_newest.begin(), _newest.begin() + _size);
+    return not gb.load_state(_state).is_set();
+  }
+
+private:
+  static size_t _words(size_t bytes)
+  {
+    return (bytes + 7) / 8;
+  }
+
+  std::vector<uint8_t> _recycle()
+  {
+    std::vector<uint8_t> diff;
+    diff.swap(_spare);
+    diff.clear();
+    return diff;
+  }
+
+  void _evict()
+  {
+    // the oldest difference leads to a frame that is gone already, so
+    // dropping the front keeps every remaining frame reachable
+    while (_bytes > _budget and _frames.size() > 1) {
+      _bytes -= _frames.front().size();
+      _frames.pop_front();
+    }
+  }
+
+  static void _put_count(std::vector<uint8_t>& out, size_t n)
+  {
+    do {
+      uint8_t b = n & 0x7F;
+      n >>= 7;
+      out.push_back(n ? b | 0x80 : b);
+    } while (n);
+  }
+
+  static size_t _get_count(uint8_t const*& cur)
+  {
+    size_t n = 0;
+    for (int shift = 0; ; shift += 7) {
+      auto const b = *cur++;
+      n |= static_cast<size_t>(b & 0x7F) << shift;
+      if (not (b & 0x80))
+        return n;
+    }
+  }
+
+  static void _encode(std::vector<uint8_t> const& now, std::vector<uint8_t> const& before, std::vector<uint8_t>& out)
+  {
+    auto const words = now.size() / 8;
+    auto const* a = now.data();
+    auto const* b = before.data();
+
+    auto const word = [a, b] (size_t i) {
+      uint64_t x, y;
+      memcpy(&x, a + i * 8, 8);
+      memcpy(&y, b + i * 8, 8);
+      return x ^ y;
+    };
+
+    size_t i = 0;
+    while (i < words) {
+      auto const zeros_start = i;
+      while (i < words and word(i) == 0)
+        ++i;
+
+      auto const literal_start = i;
+      while (i < words and word(i) != 0)
+        ++i;
+
+      _put_count(out, literal_start - zeros_start);
+      _put_count(out, i - literal_start);
+
+      auto const at = out.size();
+      out.resize(at + (i - literal_start) * 8);
+      for (auto w = literal_start; w < i; ++w) {
+        auto const x = word(w);
+        memcpy(out.data() + at + (w - literal_start) * 8, &x, 8);
+      }
+    }
+  }
+
+  static void _decode(std::vector<uint8_t> const& diff, std::vector<uint8_t>& state)
+  {
+    auto const* cur = diff.data();
+    auto const* end = cur + diff.size();
+    auto* dst = state.data();
+
+    while (cur < end) {
+      dst += _get_count(cur) * 8;
+
+      auto const literals = _get_count(cur);
+      for (size_t w = 0; w < literals; ++w, dst += 8, cur += 8) {
+        uint64_t x, y;
+        memcpy(&x, dst, 8);
+        memcpy(&y, cur, 8);
+        x ^= y;
+        memcpy(dst, &x, 8);
+      }
+    }
+  }
+
+  size_t _budget;
+  size_t _bytes = 0;
+  size_t _size  = 0; // of a state, before padding it to whole words
+
+  std::deque<std::vector<uint8_t>> _frames;  // difference to the frame before
+  std::vector<uint8_t>             _newest;  // whole state of the newest frame
+  std::vector<uint8_t>             _state;
+  std::vector<uint8_t>             _spare;   // capacity of a dropped difference
+};
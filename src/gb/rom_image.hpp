@@ -0,0 +1,131 @@
+#pragma once
+
+#include "types.h"
+#include "hash.hpp"
+
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The rom bytes the mbcs read, an image or a patched copy of one.
+struct RomView
+{
+  reg_t const* data = nullptr;
+  size_t       size = 0;
+
+  reg_t operator[](size_t i) const { return data[i]; }
+};
+
+// Read only rom contents shared by all cartridges holding the handle.
+// Files are mapped instead of read, and opening the same file again while
+// an image of it is alive returns that image, so N emulators running one
+// rom keep a single copy in memory.
+class RomImage
+{
+public:
+  typedef std::shared_ptr<RomImage const> handle_t;
+
+  ~RomImage()
+  {
+    if (_mapped)
+      munmap(const_cast<reg_t*>(_data), _size);
+  }
+
+  RomImage(RomImage const&) = delete;
+  RomImage& operator=(RomImage const&) = delete;
+
+  // nullptr if the file can not be mapped
+  static handle_t open(std::string const& path)
+  {
+    auto const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 or st.st_size <= 0) {
+      close(fd);
+      return nullptr;
+    }
+
+    auto const key = std::make_tuple(
+      st.st_dev, st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+
+    std::lock_guard<std::mutex> lock(_open_mutex());
+    auto& images = _open_images();
+
+    // images that were closed since are forgotten on the way
+    for (auto open = images.begin(); open != images.end();)
+      open = open->second.expired() ? images.erase(open) : std::next(open);
+
+    auto const it = images.find(key);
+    if (it != images.end()) {
+      if (auto image = it->second.lock()) {
+        close(fd);
+        return image;
+      }
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+      return nullptr;
+
+    handle_t const image(new RomImage(static_cast<reg_t const*>(data), st.st_size, true));
+    images[key] = image;
+
+    return image;
+  }
+
+  // for roms that do not come from a file
+  static handle_t copy(mem_t const& data)
+  {
+    auto* image = new RomImage(nullptr, data.size(), false);
+    image->_copy = data;
+    image->_data = image->_copy.data();
+    image->_hash = ::hash(image->_data, image->_size);
+
+    return handle_t(image);
+  }
+
+  reg_t const* data() const { return _data; }
+  size_t size() const { return _size; }
+
+  // computed once per image instead of once per cartridge
+  uint64_t hash() const { return _hash; }
+
+private:
+  typedef std::tuple<dev_t, ino_t, off_t, time_t, long> key_t;
+
+  RomImage(reg_t const* data, size_t size, bool mapped)
+    : _data(data)
+    , _size(size)
+    , _mapped(mapped)
+    , _hash(data ? ::hash(data, size) : 0)
+  {}
+
+  static std::mutex& _open_mutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static std::map<key_t, std::weak_ptr<RomImage const>>& _open_images()
+  {
+    static std::map<key_t, std::weak_ptr<RomImage const>> images;
+    return images;
+  }
+
+  reg_t const* _data;
+  size_t       _size;
+  bool         _mapped;
+  uint64_t     _hash;
+  mem_t        _copy;
+};
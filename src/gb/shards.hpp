@@ -0,0 +1,337 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+#include "gb.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+#include <signal.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+// Many machines split across worker processes. start() forks the workers,
+// each runs frames on its slice of clones and publishes the screens and
+// observed memory bytes of a whole frame of its slice into the next slot of
+// a ring in memory shared with this process. next() hands out those slots
+// in place, nothing is copied or serialized on the way; release() gives a
+// slot back. A worker whose ring is full waits, so a slow consumer holds
+// the workers back instead of losing frames. Buttons go the other way
+// through shared memory too, a worker reads them at the start of a frame.
+//
+// Every ring has a single producer and a single consumer, head counts the
+// slots published and tail the slots released. Workers exit when stopped,
+// or when this process is gone; a worker that dies makes next() fail.
+//
+// shared memory: control, ring per worker, buttons, slots per worker
+class Shards
+{
+public:
+  static const size_t SCREEN_SIZE   = sizeof(GR::screen_t);
+  static const size_t DEFAULT_SLOTS = 4;
+
+  // a frame of the machines first to first + count
+  struct Frame
+  {
+    size_t       worker;
+    uint64_t     step;
+    size_t       first;
+    size_t       count;
+    reg_t const* screens;      // count * 144 * 160 shades, see GB::screen()
+    reg_t const* observations; // count * observed addresses
+  };
+
+  Shards() = default;
+
+  ~Shards()
+  {
+    stop();
+  }
+
+  Shards(Shards const&) = delete;
+  Shards& operator=(Shards const&) = delete;
+
+  // Forks worker processes that run machines clones of gb as it is now
+  // between them, each with slots frames to fill ahead of the consumer.
+  // Start before other threads, a forked process only has the thread that
+  // forked it.
+  Error start(
+    GB const& gb, size_t machines, size_t workers,
+    std::vector<wide_reg_t> addresses, size_t slots = DEFAULT_SLOTS)
+  {
+    stop();
+
+    _machines  = machines;
+    _workers   = std::max<size_t>(std::min(workers, machines), 1);
+    _slots     = std::max<size_t>(slots, 1);
+    _addresses = std::move(addresses);
+
+    size_t largest = 0;
+    for (size_t w = 0; w < _workers; ++w)
+      largest = std::max(largest, _first(w + 1) - _first(w));
+    _slot_size = _align(largest * (SCREEN_SIZE + _addresses.size()));
+
+    _rings_offset   = _align(sizeof(Control));
+    _buttons_offset = _rings_offset + _workers * sizeof(Ring);
+    _slots_offset   = _align(_buttons_offset + _machines);
+    _size           = _slots_offset + _workers * _slots * _slot_size;
+
+    auto* shared = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+      return Error(Error::Code::WorkerFailed);
+
+    _shared = static_cast<uint8_t*>(shared);
+    new (_control()) Control();
+    for (size_t w = 0; w < _workers; ++w)
+      new (_ring(w)) Ring();
+    for (size_t m = 0; m < _machines; ++m)
+      new (_button(m)) std::atomic<reg_t>(0);
+
+    _taken.assign(_workers, 0);
+    _next_worker = 0;
+
+    auto const parent = getpid();
+    for (size_t w = 0; w < _workers; ++w) {
+      auto const pid = fork();
+      if (pid < 0) {
+        stop();
+        return Error(Error::Code::WorkerFailed);
+      }
+
+      if (pid == 0)
+        _work(w, gb, parent);
+
+      _pids.push_back(pid);
+    }
+
+    return Error::NoError();
+  }
+
+  // tells the workers to finish their frame and waits for them
+  void stop()
+  {
+    if (not _shared)
+      return;
+
+    _control()->stop.store(true);
+    for (auto const pid : _pids)
+      waitpid(pid, nullptr, 0);
+    _pids.clear();
+
+    munmap(_shared, _size);
+    _shared = nullptr;
+  }
+
+  size_t machines() const
+  {
+    return _machines;
+  }
+
+  size_t workers() const
+  {
+    return _workers;
+  }
+
+  // Input::BUTTON_ bits held on machine from its next frame on
+  void buttons(size_t machine, reg_t mask)
+  {
+    _button(machine)->store(mask, std::memory_order_relaxed);
+  }
+
+  // Waits for the oldest frame not handed out yet, of any worker in turn.
+  // It stays valid until it is released; the frames of a worker are
+  // released in the order they were handed out.
+  Error next(Frame& frame)
+  {
+    for (unsigned waits = 0; ; ++waits) {
+      for (size_t n = 0; n < _workers; ++n) {
+        auto const w = (_next_worker + n) % _workers;
+        auto* ring = _ring(w);
+
+        auto const step = ring->tail.load(std::memory_order_relaxed) + _taken[w];
+        if (ring->head.load(std::memory_order_acquire) <= step)
+          continue;
+
+        auto const* slot = _slot(w, step);
+        frame.worker       = w;
+        frame.step         = step;
+        frame.first        = _first(w);
+        frame.count        = _first(w + 1) - _first(w);
+        frame.screens      = slot;
+        frame.observations = slot + frame.count * SCREEN_SIZE;
+
+        ++_taken[w];
+        _next_worker = w + 1;
+        return Error::NoError();
+      }
+
+      if (_backoff(waits) and not _alive())
+        return Error(Error::Code::WorkerFailed);
+    }
+  }
+
+  void release(Frame const& frame)
+  {
+    auto* ring = _ring(frame.worker);
+    --_taken[frame.worker];
+    ring->tail.store(ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // times a worker found its ring full
+  uint64_t stalls() const
+  {
+    uint64_t stalls = 0;
+    for (size_t w = 0; w < _workers and _shared; ++w)
+      stalls += _ring(w)->stalls.load(std::memory_order_relaxed);
+
+    return stalls;
+  }
+
+private:
+  struct Control
+  {
+    std::atomic<bool> stop = { false };
+  };
+
+  struct alignas(64) Ring
+  {
+    alignas(64) std::atomic<uint64_t> head   = { 0 };
+    alignas(64) std::atomic<uint64_t> tail   = { 0 };
+    alignas(64) std::atomic<uint64_t> stalls = { 0 };
+  };
+
+  // the processes share them through plain memory
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters");
+  static_assert(std::atomic<reg_t>::is_always_lock_free, "buttons");
+  static_assert(std::atomic<bool>::is_always_lock_free, "stop");
+
+  static size_t _align(size_t size)
+  {
+    return (size + 63) & ~size_t(63);
+  }
+
+  // spins a little, then sleeps longer and longer up to a millisecond;
+  // true once it sleeps
+  static bool _backoff(unsigned waits)
+  {
+    if (waits < 64) {
+      std::this_thread::yield();
+      return false;
+    }
+
+    auto const us = std::min(1u << std::min(waits - 64, 10u), 1000u);
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+    return true;
+  }
+
+  size_t _first(size_t worker) const
+  {
+    return _machines * worker / _workers;
+  }
+
+  Control* _control() const
+  {
+    return reinterpret_cast<Control*>(_shared);
+  }
+
+  Ring* _ring(size_t worker) const
+  {
+    return reinterpret_cast<Ring*>(_shared + _rings_offset) + worker;
+  }
+
+  std::atomic<reg_t>* _button(size_t machine) const
+  {
+    return reinterpret_cast<std::atomic<reg_t>*>(_shared + _buttons_offset) + machine;
+  }
+
+  uint8_t* _slot(size_t worker, uint64_t step) const
+  {
+    return _shared + _slots_offset + (worker * _slots + step % _slots) * _slot_size;
+  }
+
+  // any worker that exited is an error, they only exit when stopped
+  bool _alive() const
+  {
+    for (auto const pid : _pids) {
+      if (waitpid(pid, nullptr, WNOHANG) != 0)
+        return false;
+    }
+
+    return true;
+  }
+
+  // the worker process, never returns
+  [[noreturn]] void _work(size_t worker, GB const& gb, pid_t parent)
+  {
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    if (getppid() != parent)
+      _exit(EXIT_FAILURE);
+
+    auto const first = _first(worker);
+    auto const count = _first(worker + 1) - first;
+
+    std::vector<std::unique_ptr<GB>> gbs;
+    for (size_t i = 0; i < count; ++i)
+      gbs.push_back(gb.clone());
+
+    auto* ring = _ring(worker);
+    auto const& stop = _control()->stop;
+
+    for (uint64_t step = 0; ; ++step) {
+      for (unsigned waits = 0; step - ring->tail.load(std::memory_order_acquire) >= _slots; ++waits) {
+        if (waits == 0)
+          ring->stalls.fetch_add(1, std::memory_order_relaxed);
+        if (stop.load(std::memory_order_relaxed) or (_backoff(waits) and getppid() != parent))
+          _exit(EXIT_SUCCESS);
+      }
+
+      if (stop.load(std::memory_order_relaxed))
+        _exit(EXIT_SUCCESS);
+
+      auto* screens      = _slot(worker, step);
+      auto* observations = screens + count * SCREEN_SIZE;
+      for (size_t i = 0; i < count; ++i) {
+        auto& machine = *gbs[i];
+        machine.buttons(_button(first + i)->load(std::memory_order_relaxed));
+        machine.run_frame();
+
+        memcpy(screens + i * SCREEN_SIZE, machine.screen().data(), SCREEN_SIZE);
+        for (auto const addr : _addresses)
+          *observations++ = machine.mem(addr);
+      }
+
+      ring->head.store(step + 1, std::memory_order_release);
+    }
+  }
+
+  size_t                  _machines  = 0;
+  size_t                  _workers   = 0;
+  size_t                  _slots     = 0;
+  size_t                  _slot_size = 0;
+  std::vector<wide_reg_t> _addresses;
+
+  uint8_t*                _shared = nullptr;
+  size_t                  _size   = 0;
+  size_t                  _rings_offset   = 0;
+  size_t                  _buttons_offset = 0;
+  size_t                  _slots_offset   = 0;
+
+  std::vector<pid_t>      _pids;
+  std::vector<uint64_t>   _taken; // handed out and not released yet, per worker
+  size_t                  _next_worker = 0;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "types.h"
+
+#include <type_traits>
+#include <vector>
+
+#include <string.h>
+
+// Appends machine state to a byte vector in host byte order. Components
+// write their registers one by one and their memories as single blocks.
+// Without a vector it only counts the bytes.
+class StateWriter
+{
+public:
+  StateWriter() = default;
+
+  StateWriter(std::vector<uint8_t>& data)
+    : _data(&data)
+  {}
+
+  template <typename T>
+  void put(T const& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "state is copied bytewise");
+    put(&value, sizeof(T));
+  }
+
+  void put(void const* src, size_t size)
+  {
+    _size += size;
+    if (not _data)
+      return;
+
+    auto const at = _data->size();
+    _data->resize(at + size);
+    memcpy(_data->data() + at, src, size);
+  }
+
+  // bytes put so far
+  size_t size() const
+  {
+    return _size;
+  }
+
+private:
+  std::vector<uint8_t>* _data = nullptr;
+  size_t                _size = 0;
+};
+
+// Reads what StateWriter wrote. Reading past the end fails the reader
+// instead of the caller checking every value.
+class StateReader
+{
+public:
+  StateReader(uint8_t const* data, size_t size)
+    : _cur(data)
+    , _end(data + size)
+  {}
+
+  template <typename T>
+  void get(T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "state is copied bytewise");
+    get(&value, sizeof(T));
+  }
+
+  void get(void* dst, size_t size)
+  {
+    if (_failed or static_cast<size_t>(_end - _cur) < size) {
+      _failed = true;
+      return;
+    }
+
+    memcpy(dst, _cur, size);
+    _cur += size;
+  }
+
+  // moves past size bytes without reading them
+  void skip(size_t size)
+  {
+    if (_failed or left() < size) {
+      _failed = true;
+      return;
+    }
+
+    _cur += size;
+  }
+
+  void fail()
+  {
+    _failed = true;
+  }
+
+  bool failed() const
+  {
+    return _failed;
+  }
+
+  // bytes not read yet
+  size_t left() const
+  {
+    return _end - _cur;
+  }
+
+  bool at_end() const
+  {
+    return _cur == _end;
+  }
+
+private:
+  uint8_t const* _cur;
+  uint8_t const* _end;
+  bool           _failed = false;
+};
@@ -4,6 +4,7 @@
 #include "mm.hpp"
 
 #include <array>
+#include <limits>
 
 class Timer
 {
@@ -12,12 +13,56 @@ public:
     : _mm(mm)
   {}
 
+  Timer(Timer const& other, MM& mm)
+    : _mm(mm)
+    , _cnt(other._cnt)
+    , _cnt2(other._cnt2)
+  {}
+
   void power_on()
   {
     _cnt = 0;
     _cnt2 = 0;
   }
 
+  void save_state(StateWriter& state) const
+  {
+    state.put(_cnt);
+    state.put(_cnt2);
+  }
+
+  void load_state(StateReader& state)
+  {
+    state.get(_cnt);
+    state.get(_cnt2);
+  }
+
+  // reads what load_state would, the counters stay below their periods
+  bool check_state(StateReader& state) const
+  {
+    int cnt  = 0;
+    int cnt2 = 0;
+    state.get(cnt);
+    state.get(cnt2);
+
+    return cnt >= 0 and cnt < _cls[0] and cnt2 >= 0 and cnt2 <= _cls[1];
+  }
+
+  // ticks from now on that request none of the enabled interrupts
+  uint32_t quiet_ticks(reg_t enabled) const
+  {
+    auto const tac = _mm.read(0xFF07);
+    if (not (enabled & 0x04) or not (tac & 0x04))
+      return std::numeric_limits<uint32_t>::max();
+
+    // TIMA counts up once the counter reaches the period and requests the
+    // interrupt when it overflows
+    auto const period     = _cls[tac & 0x3];
+    auto const first      = _cnt < period ? period - _cnt : 1;
+    auto const increments = 0x100 - _mm.read(0xFF05);
+    return first + (increments - 1) * period - 1;
+  }
+
   void tick()
   {
     ++_cnt2;
@@ -53,8 +98,8 @@ public:
 private:
   MM& _mm;
 
-  int _cnt;
-  int _cnt2; // FIXME rename into div_cnt or something
+  int _cnt  = 0;
+  int _cnt2 = 0; // FIXME rename into div_cnt or something
 
   std::array<int, 4> const _cls = {{ 1024, 16, 64, 256 }};
 };
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "types.h"
+#include "error.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Ring buffer of the last instructions the cpu started, kept in binary form
+// so tracing costs a few stores per instruction instead of a printf. With
+// the cached and jit backends a bulk loop or translated block shows up as
+// one record. yagbe-trace turns a dump back into text.
+//
+// file: "YGBT", version, record count, records oldest first
+class Trace
+{
+public:
+  struct Record
+  {
+    uint64_t   cycle;
+    wide_reg_t pc;
+    uint16_t   bank;
+    wide_reg_t sp;
+    wide_reg_t af;
+    wide_reg_t bc;
+    wide_reg_t de;
+    wide_reg_t hl;
+    reg_t      op;
+    reg_t      b1;
+    reg_t      b2;
+    reg_t      ime;
+    reg_t      lcdc;
+    reg_t      reserved[3];
+  };
+
+  static_assert(sizeof(Record) == 32, "trace records are written as is");
+
+  static const size_t DEFAULT_SIZE = 1 << 16;
+
+  // bump whenever Record changes
+  static constexpr uint32_t FILE_VERSION = 1;
+
+  bool enabled() const
+  {
+    return _enabled;
+  }
+
+  // size is rounded up to a power of two; disabling keeps the records
+  void enable(bool enable, size_t size = DEFAULT_SIZE)
+  {
+    _enabled = enable;
+    if (not enable)
+      return;
+
+    size_t capacity = 1;
+    while (capacity < size)
+      capacity <<= 1;
+
+    if (capacity != _records.size()) {
+      _records.assign(capacity, Record());
+      _next = 0;
+    }
+  }
+
+  void clear()
+  {
+    _next = 0;
+  }
+
+  Record& next()
+  {
+    return _records[_next++ & (_records.size() - 1)];
+  }
+
+  size_t size() const
+  {
+    return std::min<uint64_t>(_next, _records.size());
+  }
+
+  // only uses open and write so it can be called from a signal handler
+  bool save(char const* path) const
+  {
+    auto const fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return false;
+
+    uint32_t const count = size();
+    auto const first = _next - count;
+    auto const mask  = _records.size() - 1;
+
+    bool ok =
+      _write(fd, FILE_MAGIC, sizeof(FILE_MAGIC)) and
+      _write(fd, &FILE_VERSION, sizeof(FILE_VERSION)) and
+      _write(fd, &count, sizeof(count));
+
+    // oldest first, in at most two runs
+    if (ok and count > 0) {
+      auto const start = first & mask;
+      auto const head  = std::min<size_t>(count, _records.size() - start);
+      ok =
+        _write(fd, &_records[start], head * sizeof(Record)) and
+        _write(fd, &_records[0], (count - head) * sizeof(Record));
+    }
+
+    return close(fd) == 0 and ok;
+  }
+
+  static Error load(std::vector<reg_t> const& data, std::vector<Record>& records)
+  {
+    uint32_t version = 0;
+    uint32_t count   = 0;
+    auto const header = sizeof(FILE_MAGIC) + sizeof(version) + sizeof(count);
+
+    if (data.size() < header or memcmp(data.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+      return Error(Error::Code::TraceInvalid);
+
+    memcpy(&version, data.data() + 4, sizeof(version));
+    memcpy(&count, data.data() + 8, sizeof(count));
+
+    if (version != FILE_VERSION or data.size() - header != count * sizeof(Record))
+      return Error(Error::Code::TraceInvalid);
+
+    records.resize(count);
+    memcpy(records.data(), data.data() + header, count * sizeof(Record));
+
+    return Error::NoError();
+  }
+
+private:
+  static constexpr char const FILE_MAGIC[4] = { 'Y', 'G', 'B', 'T' };
+
+  static bool _write(int fd, void const* src, size_t size)
+  {
+    auto const* bytes = static_cast<char const*>(src);
+    while (size > 0) {
+      auto const n = ::write(fd, bytes, size);
+      if (n <= 0)
+        return false;
+
+      bytes += n;
+      size  -= n;
+    }
+
+    return true;
+  }
+
+  bool                _enabled = false;
+  std::vector<Record> _records;
+  uint64_t            _next    = 0;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "types.h"
+
+#define YAGBE_VERSION "0.0.1"
+
+// bump whenever the core decodes or runs code differently; files holding
+// derived data such as decoded code are only reused by the same core
+static constexpr uint32_t CORE_VERSION = 1;
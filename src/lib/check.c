@@ -0,0 +1,151 @@
+/*
+ * Uses libyagbe the way an embedder would, through nothing but yagbe.h,
+ * so a broken export or interface fails the build or this run.
+ */
+
+#include "yagbe.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void expect(int ok, char const* what)
+{
+  if (ok)
+    return;
+
+  printf("CHECK: %s\n", what);
+  ++failures;
+}
+
+static void count_lines(char const* line, void* user)
+{
+  (void)line;
+  ++*(int*)user;
+}
+
+/* 32 KB without a mapper that turns the lcd on and counts into c000 */
+static void make_rom(uint8_t* rom, size_t size)
+{
+  static uint8_t const entry[] = { 0x00, 0xC3, 0x50, 0x01 };
+  static uint8_t const code[]  = {
+    0x3E, 0x91, 0xE0, 0x40,  /* ld a,91 ; ldh (40),a */
+    0x3C,                    /* inc a */
+    0xEA, 0x00, 0xC0,        /* ld (c000),a */
+    0x18, 0xFA               /* jr -6 */
+  };
+
+  memset(rom, 0, size);
+  memcpy(rom + 0x0100, entry, sizeof(entry));
+  memcpy(rom + 0x0150, code, sizeof(code));
+}
+
+static void run(yagbe* gb, int frames)
+{
+  int i;
+  for (i = 0; i < frames; ++i)
+    yagbe_run_frame(gb);
+}
+
+static void check_states(yagbe* gb)
+{
+  size_t size = 0;
+  size_t later_size = 0;
+  uint8_t* saved;
+  uint8_t* later;
+
+  expect(yagbe_save_state(gb, NULL, 0, &size) == YAGBE_BUFFER_TOO_SMALL && size > 0,
+         "state size not reported");
+
+  saved = malloc(size);
+  later = malloc(size);
+  expect(yagbe_save_state(gb, saved, size, &size) == YAGBE_OK, "state not saved");
+  run(gb, 5);
+  expect(yagbe_save_state(gb, later, size, &later_size) == YAGBE_OK, "later state not saved");
+
+  expect(yagbe_load_state(gb, saved, size) == YAGBE_OK, "state not loaded");
+  run(gb, 5);
+  expect(yagbe_save_state(gb, saved, size, &size) == YAGBE_OK &&
+         memcmp(saved, later, size) == 0,
+         "run after loading differs");
+
+  expect(yagbe_load_state(gb, saved, size - 1) == YAGBE_STATE_INVALID, "truncated state loaded");
+
+  free(saved);
+  free(later);
+}
+
+static void check_batch(yagbe const* gb)
+{
+  uint16_t const addresses[] = { 0xC000, 0xFF40 };
+  uint8_t const  buttons[4]  = { 0, YAGBE_BUTTON_A, YAGBE_BUTTON_START, 0 };
+  uint8_t const* observations;
+  size_t i;
+
+  yagbe_batch* batch = yagbe_batch_create(gb, 4, 2, addresses, 2);
+  expect(batch != NULL, "batch not created");
+  if (batch == NULL)
+    return;
+
+  for (i = 0; i < 3; ++i)
+    yagbe_batch_step(batch, buttons);
+  yagbe_batch_reset(batch, 0);
+  yagbe_batch_step(batch, buttons);
+
+  observations = yagbe_batch_observations(batch);
+  expect(yagbe_batch_screens(batch) != NULL && observations != NULL, "batch has no buffers");
+  for (i = 0; i < 4; ++i)
+    expect(observations[i * 2 + 1] == 0x91, "batch observed the wrong memory");
+  expect(yagbe_batch_frames_per_second(batch) > 0, "batch did not count its frames");
+
+  yagbe_batch_destroy(batch);
+}
+
+int main(void)
+{
+  static uint8_t rom[0x8000];
+  int lines = 0;
+  yagbe* gb;
+  yagbe* clone;
+
+  expect(yagbe_api_version() == YAGBE_API_VERSION, "library of another version");
+
+  gb = yagbe_create();
+  expect(gb != NULL, "emulator not created");
+  if (gb == NULL)
+    return EXIT_FAILURE;
+
+  expect(yagbe_power_on(gb, 1) == YAGBE_NO_ROM, "powered on without a rom");
+  expect(yagbe_load_rom(gb, rom, 0x100) == YAGBE_ROM_NOT_SUPPORTED, "rom without header loaded");
+
+  make_rom(rom, sizeof(rom));
+  yagbe_set_log(count_lines, &lines);
+  expect(yagbe_load_rom(gb, rom, sizeof(rom)) == YAGBE_OK, "rom not loaded");
+  expect(yagbe_power_on(gb, 1) == YAGBE_OK, "not powered on");
+  expect(lines > 0, "nothing logged");
+  yagbe_set_log(NULL, NULL);
+
+  expect(yagbe_set_backend(gb, YAGBE_BACKEND_REFERENCE) == YAGBE_OK, "reference backend missing");
+  expect(yagbe_set_backend(gb, YAGBE_BACKEND_CACHED) == YAGBE_OK, "cached backend missing");
+
+  yagbe_set_buttons(gb, YAGBE_BUTTON_START);
+  run(gb, 2);
+  expect(yagbe_screen(gb) != NULL, "no screen");
+
+  check_states(gb);
+
+  clone = yagbe_clone(gb);
+  expect(clone != NULL, "emulator not cloned");
+  if (clone != NULL) {
+    run(clone, 1);
+    yagbe_destroy(clone);
+  }
+
+  check_batch(gb);
+  yagbe_destroy(gb);
+
+  printf("CHECK: c api    %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+#include "yagbe.h"
+
+#include "../gb/gb.hpp"
+#include "../gb/batch.hpp"
+
+#include <exception>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <string.h>
+
+// The core is compiled once here, users of the library only see yagbe.h.
+// Nothing may throw through the C functions, the allocations that can fail
+// are caught.
+
+static_assert(YAGBE_SCREEN_WIDTH * YAGBE_SCREEN_HEIGHT == sizeof(GR::screen_t), "screen size");
+static_assert(YAGBE_BUTTON_START == Input::BUTTON_START, "button bits");
+static_assert(YAGBE_BACKEND_JIT == static_cast<int>(Backend::Kind::Jit), "backend kinds");
+
+struct yagbe
+{
+  std::unique_ptr<GB>  gb;
+  std::vector<uint8_t> state; // reused by every save
+  bool                 rom = false;
+};
+
+struct yagbe_batch
+{
+  yagbe_batch(GB const& gb, size_t count, size_t threads)
+    : batch(gb, count, threads)
+  {}
+
+  Batch batch;
+};
+
+// the core prints to stdout for the tools, not for whoever embeds it
+static bool const quiet = (Log::sink(nullptr, nullptr), true);
+
+uint32_t yagbe_api_version(void)
+{
+  return YAGBE_API_VERSION;
+}
+
+yagbe* yagbe_create(void)
+{
+  try {
+    auto handle = std::make_unique<yagbe>();
+    handle->gb = std::make_unique<GB>();
+    return handle.release();
+  }
+  catch (std::bad_alloc const&) {
+    return nullptr;
+  }
+}
+
+void yagbe_destroy(yagbe* gb)
+{
+  delete gb;
+}
+
+yagbe* yagbe_clone(yagbe const* gb)
+{
+  try {
+    auto handle = std::make_unique<yagbe>();
+    handle->gb  = gb->gb->clone();
+    handle->rom = gb->rom;
+    return handle.release();
+  }
+  catch (std::bad_alloc const&) {
+    return nullptr;
+  }
+}
+
+yagbe_result yagbe_load_rom(yagbe* gb, void const* data, size_t size)
+{
+  // the header alone is 0x150 bytes
+  if (size < 0x150)
+    return YAGBE_ROM_NOT_SUPPORTED;
+
+  auto const* bytes = static_cast<uint8_t const*>(data);
+
+  try {
+    auto const error = gb->gb->insert_rom(RomImage::copy(mem_t(bytes, bytes + size)));
+    gb->rom = not error.is_set();
+    return error.is_set() ? YAGBE_ROM_NOT_SUPPORTED : YAGBE_OK;
+  }
+  catch (std::bad_alloc const&) {
+    gb->rom = false;
+    return YAGBE_ROM_NOT_SUPPORTED;
+  }
+}
+
+yagbe_result yagbe_power_on(yagbe* gb, int fast_boot)
+{
+  if (not gb->rom)
+    return YAGBE_NO_ROM;
+
+  gb->gb->power_on(fast_boot != 0);
+  return YAGBE_OK;
+}
+
+yagbe_result yagbe_set_backend(yagbe* gb, yagbe_backend backend)
+{
+  if (backend < YAGBE_BACKEND_REFERENCE or backend > YAGBE_BACKEND_JIT or
+      not gb->gb->backend(static_cast<Backend::Kind>(backend)))
+    return YAGBE_BACKEND_NOT_AVAILABLE;
+
+  return YAGBE_OK;
+}
+
+void yagbe_run_frame(yagbe* gb)
+{
+  if (gb->rom)
+    gb->gb->run_frame();
+}
+
+void yagbe_set_buttons(yagbe* gb, uint8_t buttons)
+{
+  gb->gb->buttons(buttons);
+}
+
+uint8_t const* yagbe_screen(yagbe const* gb)
+{
+  return gb->gb->screen().data();
+}
+
+yagbe_result yagbe_save_state(yagbe* gb, void* buffer, size_t capacity, size_t* size)
+{
+  if (not gb->rom)
+    return YAGBE_NO_ROM;
+
+  gb->gb->save_state(gb->state);
+  *size = gb->state.size();
+  if (capacity < gb->state.size())
+    return YAGBE_BUFFER_TOO_SMALL;
+
+  memcpy(buffer, gb->state.data(), gb->state.size());
+  return YAGBE_OK;
+}
+
+yagbe_result yagbe_load_state(yagbe* gb, void const* buffer, size_t size)
+{
+  if (not gb->rom)
+    return YAGBE_NO_ROM;
+
+  auto const error = gb->gb->load_state(static_cast<uint8_t const*>(buffer), size);
+  return error.is_set() ? YAGBE_STATE_INVALID : YAGBE_OK;
+}
+
+yagbe_batch* yagbe_batch_create(
+  yagbe const* gb, size_t count, size_t threads,
+  uint16_t const* addresses, size_t address_count)
+{
+  if (not gb->rom)
+    return nullptr;
+
+  // starting the threads may fail as well
+  try {
+    auto handle = std::make_unique<yagbe_batch>(*gb->gb, count, threads);
+    handle->batch.observe(std::vector<wide_reg_t>(addresses, addresses + address_count));
+    return handle.release();
+  }
+  catch (std::exception const&) {
+    return nullptr;
+  }
+}
+
+void yagbe_batch_destroy(yagbe_batch* batch)
+{
+  delete batch;
+}
+
+void yagbe_batch_step(yagbe_batch* batch, uint8_t const* buttons)
+{
+  batch->batch.step(buttons);
+}
+
+void yagbe_batch_reset(yagbe_batch* batch, size_t index)
+{
+  batch->batch.reset(index);
+}
+
+uint8_t const* yagbe_batch_screens(yagbe_batch const* batch)
+{
+  return batch->batch.screens();
+}
+
+uint8_t const* yagbe_batch_observations(yagbe_batch const* batch)
+{
+  return batch->batch.observations();
+}
+
+double yagbe_batch_frames_per_second(yagbe_batch const* batch)
+{
+  return batch->batch.frames_per_second();
+}
+
+void yagbe_set_log(yagbe_log log, void* user)
+{
+  Log::sink(log, user);
+}
@@ -0,0 +1,143 @@
+#ifndef YAGBE_H
+#define YAGBE_H
+
+/*
+ * C interface of libyagbe, for embedding the emulator in other languages
+ * and services. Emulators are independent of each other and may be driven
+ * from different threads, one thread per emulator at a time.
+ *
+ *   yagbe* gb = yagbe_create();
+ *   yagbe_load_rom(gb, rom, rom_size);
+ *   yagbe_power_on(gb, 1);
+ *   for (;;) {
+ *     yagbe_set_buttons(gb, YAGBE_BUTTON_START);
+ *     yagbe_run_frame(gb);
+ *     show(yagbe_screen(gb));
+ *   }
+ *   yagbe_destroy(gb);
+ *
+ * Functions only add to this interface, YAGBE_API_VERSION counts additions.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define YAGBE_API __attribute__((visibility("default")))
+#else
+#define YAGBE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define YAGBE_API_VERSION   3
+
+#define YAGBE_SCREEN_WIDTH  160
+#define YAGBE_SCREEN_HEIGHT 144
+
+typedef struct yagbe yagbe;
+typedef struct yagbe_batch yagbe_batch;
+
+typedef enum yagbe_result {
+  YAGBE_OK = 0,
+  YAGBE_ROM_NOT_SUPPORTED,
+  YAGBE_NO_ROM,
+  YAGBE_BACKEND_NOT_AVAILABLE,
+  YAGBE_STATE_INVALID,
+  YAGBE_BUFFER_TOO_SMALL
+} yagbe_result;
+
+typedef enum yagbe_backend {
+  YAGBE_BACKEND_REFERENCE = 0,
+  YAGBE_BACKEND_CACHED    = 1,
+  YAGBE_BACKEND_JIT       = 2
+} yagbe_backend;
+
+/* bits of the button mask */
+#define YAGBE_BUTTON_RIGHT  0x01
+#define YAGBE_BUTTON_LEFT   0x02
+#define YAGBE_BUTTON_UP     0x04
+#define YAGBE_BUTTON_DOWN   0x08
+#define YAGBE_BUTTON_A      0x10
+#define YAGBE_BUTTON_B      0x20
+#define YAGBE_BUTTON_SELECT 0x40
+#define YAGBE_BUTTON_START  0x80
+
+/* YAGBE_API_VERSION of the library that is actually loaded */
+YAGBE_API uint32_t yagbe_api_version(void);
+
+/* NULL when out of memory */
+YAGBE_API yagbe* yagbe_create(void);
+YAGBE_API void yagbe_destroy(yagbe* gb);
+
+/* An independent emulator in the same state sharing the rom, NULL when out
+ * of memory */
+YAGBE_API yagbe* yagbe_clone(yagbe const* gb);
+
+/* The rom is copied, clones share the copy. Must be followed by
+ * yagbe_power_on. */
+YAGBE_API yagbe_result yagbe_load_rom(yagbe* gb, void const* data, size_t size);
+
+/* fast_boot skips the boot rom */
+YAGBE_API yagbe_result yagbe_power_on(yagbe* gb, int fast_boot);
+
+YAGBE_API yagbe_result yagbe_set_backend(yagbe* gb, yagbe_backend backend);
+
+YAGBE_API void yagbe_run_frame(yagbe* gb);
+
+/* YAGBE_BUTTON_ bits of the buttons held from now on */
+YAGBE_API void yagbe_set_buttons(yagbe* gb, uint8_t buttons);
+
+/* YAGBE_SCREEN_WIDTH * YAGBE_SCREEN_HEIGHT shades from 0 (white) to 3,
+ * row by row. The pointer stays valid until yagbe_destroy and the screen
+ * is drawn into it while a frame runs. */
+YAGBE_API uint8_t const* yagbe_screen(yagbe const* gb);
+
+/* Writes the whole machine into buffer and sets size to the bytes needed.
+ * The size only depends on the rom. With a buffer smaller than that,
+ * nothing is written and YAGBE_BUFFER_TOO_SMALL is returned. */
+YAGBE_API yagbe_result yagbe_save_state(yagbe* gb, void* buffer, size_t capacity, size_t* size);
+
+/* States are only loaded into emulators running the same rom. A state
+ * that does not fit leaves the emulator untouched. */
+YAGBE_API yagbe_result yagbe_load_state(yagbe* gb, void const* buffer, size_t size);
+
+/* Since version 2: count emulators that all start as clones of gb and
+ * run one frame per step on a pool of threads, 0 threads is one per core.
+ * After every step the memory at each of the address_count addresses is
+ * read into the observations. NULL without a rom or when out of memory. */
+YAGBE_API yagbe_batch* yagbe_batch_create(
+  yagbe const* gb, size_t count, size_t threads,
+  uint16_t const* addresses, size_t address_count);
+YAGBE_API void yagbe_batch_destroy(yagbe_batch* batch);
+
+/* buttons holds a YAGBE_BUTTON_ mask for each emulator */
+YAGBE_API void yagbe_batch_step(yagbe_batch* batch, uint8_t const* buttons);
+
+/* emulator index back to the state of gb when the batch was created */
+YAGBE_API void yagbe_batch_reset(yagbe_batch* batch, size_t index);
+
+/* The screens of all emulators one after the other, laid out as
+ * yagbe_screen, and address_count bytes for each emulator. Both pointers
+ * stay valid until yagbe_batch_destroy. */
+YAGBE_API uint8_t const* yagbe_batch_screens(yagbe_batch const* batch);
+YAGBE_API uint8_t const* yagbe_batch_observations(yagbe_batch const* batch);
+
+/* frames of all emulators together per second spent stepping */
+YAGBE_API double yagbe_batch_frames_per_second(yagbe_batch const* batch);
+
+/* Since version 3: the library prints nothing, messages of the core such
+ * as the cartridge found by yagbe_power_on are passed to log instead, one
+ * line without newline per call. NULL discards them, which is the default.
+ * All emulators share the log and call it from the threads running them,
+ * set it before any of them run. */
+typedef void (*yagbe_log)(char const* line, void* user);
+YAGBE_API void yagbe_set_log(yagbe_log log, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
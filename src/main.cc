@@ -1,6 +1,8 @@
 #include <SDL2/SDL.h>
 
 #include "gb/gb.hpp"
+#include "gb/movie.hpp"
+#include "gb/rewind.hpp"
 #include "ui-sdl2/ui.hpp"
 
 #include <iostream>
@@ -11,24 +13,194 @@
 #include <cstdlib>
 #include <iterator>
 
-int main(int argc, char** argv)
+#include <signal.h>
+
+static Trace const*          trace           = nullptr;
+static std::string           trace_path;
+static volatile sig_atomic_t trace_requested = 0;
+
+static void on_crash(int sig)
 {
-  if (argc < 2)
-    return EXIT_FAILURE;
+  if (trace)
+    trace->save(trace_path.c_str());
 
-  std::string const rom_path = argv[1];
-  std::string const sav_path = rom_path + ".sav"; // FIXME do it properly
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
 
-  std::ifstream s_cart(
-    rom_path,
-    std::ios::in | std::ios::binary);
+static void on_trace_request(int)
+{
+  trace_requested = 1;
+}
+
+// "[BB:]AAAA" with banks as MM::bank() numbers them; without one it is 0
+// below 0x4000, 1 up to 0x8000 and MM::BANK_RAM above, the boot rom is
+// MM::BANK_BOOT
+static void add_breakpoint(GB& gb, std::string const& arg)
+{
+  auto const colon = arg.find(':');
+  auto const pc = std::strtoul(arg.c_str() + (colon == std::string::npos ? 0 : colon + 1), nullptr, 16);
+  auto const bank = colon != std::string::npos
+    ? std::strtoul(arg.c_str(), nullptr, 16)
+    : pc < 0x4000 ? 0 : pc < 0x8000 ? 1 : MM::BANK_RAM;
+
+  gb.debugger().break_at(bank, pc);
+}
+
+// "AAAA[:r|w|rw]", watching reads and writes by default
+static void add_watchpoint(GB& gb, std::string const& arg)
+{
+  auto const colon = arg.find(':');
+  auto const addr = std::strtoul(arg.c_str(), nullptr, 16);
+  auto const mode = colon == std::string::npos ? "rw" : arg.substr(colon + 1);
+
+  reg_t kinds = 0;
+  if (mode.find('r') != std::string::npos)
+    kinds |= Debugger::WATCH_READ;
+  if (mode.find('w') != std::string::npos)
+    kinds |= Debugger::WATCH_WRITE;
+
+  gb.debugger().watch(addr, kinds);
+}
 
-  GB::cartridge_t cart(
-    (std::istreambuf_iterator<char>(s_cart)),
+static void save_state(GB const& gb, std::string const& path)
+{
+  std::vector<uint8_t> state;
+  gb.save_state(state);
+
+  std::ofstream s(path, std::ios::out | std::ios::binary);
+  s.write(reinterpret_cast<char const*>(state.data()), state.size());
+  printf("STATE: %s %s\n", s ? "saved" : "could not save", path.c_str());
+}
+
+static void load_state(GB& gb, std::string const& path)
+{
+  std::ifstream s(path, std::ios::in | std::ios::binary);
+  std::vector<uint8_t> const state(
+    (std::istreambuf_iterator<char>(s)),
     std::istreambuf_iterator<char>());
 
+  auto const error = gb.load_state(state);
+  printf("STATE: %s %s\n", error.is_set() ? error.text().c_str() : "loaded", path.c_str());
+}
+
+// Shows the screen frames ahead of the game, with the input held now, and
+// goes back. What the game draws in response to a button shows up that
+// many frames earlier. Only the last frame ahead is drawn.
+static void show_ahead(GB& gb, UiSDL& ui, int frames, std::vector<uint8_t>& state)
+{
+  gb.save_state(state);
+
+  for (int i = 0; i < frames; ++i) {
+    gb.render(i + 1 == frames);
+    gb.run_frame();
+  }
+  ui.draw();
+
+  gb.render(true);
+  gb.load_state(state);
+}
+
+// as fast as possible, checking every frame against the recording
+static bool play_movie(GB& gb, std::string const& path)
+{
+  Movie movie;
+  auto const error = movie.load(path);
+  if (error.is_set()) {
+    printf("MOVIE: %s %s\n", error.text().c_str(), path.c_str());
+    return false;
+  }
+
+  size_t played = 0;
+  auto const start = std::chrono::steady_clock::now();
+  auto const play_error = movie.play(gb, played);
+  auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (play_error.is_set()) {
+    printf("MOVIE: %s %s\n", play_error.text().c_str(), path.c_str());
+    return false;
+  }
+
+  printf("MOVIE: %zu frames in %.2f s, %.1f frames/s\n", played, seconds, played / seconds);
+  if (played != movie.frames()) {
+    printf("MOVIE: frame %zu differs from the recording\n", played);
+    return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  std::string   rom_path;
+  Backend::Kind backend   = Backend::Kind::Cached;
+  bool          trace_cpu = false;
+  bool          profile   = false;
+  bool          stats     = false;
+  bool          fast_boot = false;
+  size_t        rewind_mb = Rewind::DEFAULT_BUDGET >> 20;
+  int           run_ahead = 0;
+  std::string   opcodes;
+  std::string   record_path;
+  std::string   play_path;
+
+  std::vector<std::string> cheats;
+  std::vector<std::string> breakpoints;
+  std::vector<std::string> watchpoints;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--jit")
+      backend = Backend::Kind::Jit;
+    else if (arg == "--trace")
+      trace_cpu = true;
+    else if (arg == "--profile")
+      profile = true;
+    else if (arg == "--stats")
+      stats = true;
+    else if (arg == "--opcodes" and i + 1 < argc)
+      opcodes = argv[++i];
+    else if (arg == "--fast-boot")
+      fast_boot = true;
+    else if (arg == "--rewind" and i + 1 < argc)
+      rewind_mb = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--run-ahead" and i + 1 < argc)
+      run_ahead = std::atoi(argv[++i]);
+    else if (arg == "--record" and i + 1 < argc)
+      record_path = argv[++i];
+    else if (arg == "--play" and i + 1 < argc)
+      play_path = argv[++i];
+    else if (arg == "--cheat" and i + 1 < argc)
+      cheats.push_back(argv[++i]);
+    else if (arg == "--break" and i + 1 < argc)
+      breakpoints.push_back(argv[++i]);
+    else if (arg == "--watch" and i + 1 < argc)
+      watchpoints.push_back(argv[++i]);
+    else if (arg == "--backend" and i + 1 < argc) {
+      if (not Backend::parse(argv[++i], backend)) {
+        printf("unknown backend %s (reference, cached or jit)\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    else
+      rom_path = arg;
+  }
+
+  if (rom_path.empty())
+    return EXIT_FAILURE;
+
+  std::string const sav_path = rom_path + ".sav"; // FIXME do it properly
+  std::string const ygc_path = rom_path + ".ygc";
+  std::string const profile_path = rom_path + ".profile";
+  std::string const state_path = rom_path + ".state";
+  std::string const sym_path = rom_path.substr(0, rom_path.rfind('.')) + ".sym";
+  trace_path = rom_path + ".trace";
+
   GB gb;
-  auto const error = gb.insert_rom(cart);
+  if (not gb.backend(backend))
+    printf("BACKEND: %s not available on this platform\n", Backend::name(backend));
+
+  auto const error = gb.insert_rom(RomImage::open(rom_path));
   if (error.is_set()) {
     printf("%s\n", error.text().c_str());
     return EXIT_FAILURE;
@@ -43,19 +215,118 @@ int main(int argc, char** argv)
     std::istreambuf_iterator<char>());
   
   gb.load_ram(sav);
-  gb.power_on();
+  gb.power_on(fast_boot);
+
+  // replays run without ui and leave the battery save alone
+  if (not play_path.empty())
+    return play_movie(gb, play_path) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  // written behind the emulation, the rest on exit
+  BatterySave battery(sav_path, gb.ram());
+
+  for (auto const& cheat : cheats) {
+    auto const cheat_error = gb.add_cheat(cheat);
+    if (cheat_error.is_set())
+      printf("CHEAT: %s %s\n", cheat.c_str(), cheat_error.text().c_str());
+  }
+
+  auto const cache_error = gb.load_code_cache(ygc_path);
+  if (cache_error.is_set())
+    printf("CACHE: %s\n", cache_error.text().c_str());
+
+  // written on a crash and on SIGUSR1
+  if (trace_cpu) {
+    gb.trace().enable(true);
+    trace = &gb.trace();
+
+    for (auto sig : { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT })
+      signal(sig, on_crash);
+    signal(SIGUSR1, on_trace_request);
+  }
+
+  gb.profiler().enable(profile);
+  gb.opcode_stats().enable(not opcodes.empty());
+
+  for (auto const& breakpoint : breakpoints)
+    add_breakpoint(gb, breakpoint);
+  for (auto const& watchpoint : watchpoints)
+    add_watchpoint(gb, watchpoint);
 
   UiSDL ui(gb, 3, false, false);
 
+  // going back in time would make the recording useless
+  Movie movie;
+  bool const recording = not record_path.empty();
+  if (recording) {
+    movie.start(gb, fast_boot);
+    rewind_mb = 0;
+  }
+
+  // a state per frame while playing, stepped back through while the
+  // rewind key is held; a budget of 0 turns it off
+  Rewind rewind(rewind_mb << 20);
+
+  std::vector<uint8_t> ahead_state;
+
   int frame = 0;
   auto start = std::chrono::steady_clock::now();
   while(ui.is_running()) {
 
-    do {
-      gb.tick();
+    if (ui.rewinding() and rewind_mb > 0) {
+      rewind.pop(gb);
+    }
+    else {
+      auto const buttons = gb.buttons();
+      gb.run_frame();
+
+      // there is no interactive debugger yet, hits are logged
+      if (gb.debugger().stopped()) {
+        static char const* const kinds[] = { "", "break", "read", "write" };
+        auto const& hit = gb.debugger().hit();
+        printf(
+          "DEBUG: %s %04x value:%02x\n",
+          kinds[static_cast<int>(hit.kind)], hit.addr, hit.value);
+        gb.dbg();
+        gb.debugger().resume();
+        continue;
+      }
+
+      if (rewind_mb > 0)
+        rewind.push(gb);
+      if (recording)
+        movie.record(buttons, gb);
+    }
+
+    battery.update(gb.ram(), gb.take_dirty_ram_banks());
+
+    // breakpoints would be hit ahead of time
+    if (run_ahead > 0 and not ui.rewinding() and not gb.debugger().armed()) {
+      ui.poll();
+      show_ahead(gb, ui, run_ahead, ahead_state);
+    }
+    else {
+      ui.tick();
+    }
+
+    switch (ui.take_request()) {
+    case UiSDL::Request::SaveState:
+      save_state(gb, state_path);
+      break;
+    case UiSDL::Request::LoadState:
+      if (recording)
+        printf("STATE: not loaded while recording\n");
+      else
+        load_state(gb, state_path);
+      break;
+    case UiSDL::Request::None:
+      break;
+    }
+
+    if (trace_requested) {
+      trace_requested = 0;
+      if (trace->save(trace_path.c_str()))
+        printf("TRACE: %s\n", trace_path.c_str());
     }
-    while(not gb.is_v_blank_completed());
-    ui.tick();
 
     auto const end = std::chrono::steady_clock::now();
     auto const delta = end - start;
@@ -68,13 +339,68 @@ int main(int argc, char** argv)
       std::this_thread::sleep_for(std::chrono::milliseconds(sleep));
   }
 
-  std::ofstream s_sav_out(
-    sav_path,
-    std::ios::out | std::ios::binary);
-  std::ostream_iterator<char> s_sav_out_it(s_sav_out);
+  battery.update(gb.ram(), gb.take_dirty_ram_banks());
+
+  if (recording) {
+    auto const movie_error = movie.save(record_path);
+    printf(
+      "MOVIE: %s %s, %zu frames\n",
+      movie_error.is_set() ? movie_error.text().c_str() : "recorded",
+      record_path.c_str(), movie.frames());
+  }
+
+  auto const save_cache_error = gb.save_code_cache(ygc_path);
+  if (save_cache_error.is_set())
+    printf("CACHE: %s\n", save_cache_error.text().c_str());
+
+  if (profile) {
+    Symbols symbols;
+    symbols.load(sym_path);
 
-  auto const ram = gb.ram();
-  std::copy(ram.begin(), ram.end(), s_sav_out_it);
+    auto const profile_error = gb.profiler().write(profile_path, symbols, Profiler::Format::Folded);
+    if (profile_error.is_set())
+      printf("PROFILE: %s\n", profile_error.text().c_str());
+
+    auto const functions = gb.profiler().functions(symbols);
+    for (size_t i = 0; i < std::min<size_t>(functions.size(), 10); ++i) {
+      printf(
+        "PROFILE: %-32s %llu\n",
+        functions[i].first.c_str(),
+        static_cast<unsigned long long>(functions[i].second));
+    }
+  }
+
+  if (opcodes == "json")
+    gb.opcode_stats().print_json(stdout);
+  else if (not opcodes.empty())
+    gb.opcode_stats().print(stdout);
+
+  if (not stats)
+    return EXIT_SUCCESS;
+
+  if (auto const blocks = gb.block_stats()) {
+    printf(
+      "CACHE: blocks:%llu (%llu loaded) hit rate:%.4f avg block length:%.2f uncached fetches:%llu\n",
+      static_cast<unsigned long long>(blocks->blocks),
+      static_cast<unsigned long long>(blocks->loaded),
+      blocks->hit_rate(),
+      blocks->avg_block_length(),
+      static_cast<unsigned long long>(blocks->uncached));
+  }
+
+  if (auto const idioms = gb.idiom_stats()) {
+    for (size_t i = 1; i < idioms->size(); ++i) {
+      auto const& stats = (*idioms)[i];
+      if (stats.runs == 0)
+        continue;
+
+      printf(
+        "IDIOM: %-12s runs:%llu iterations:%llu\n",
+        Idioms::name(static_cast<Idioms::Kind>(i)),
+        static_cast<unsigned long long>(stats.runs),
+        static_cast<unsigned long long>(stats.iterations));
+    }
+  }
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,194 @@
+#include "../gb/gb.hpp"
+#include "../gb/batch.hpp"
+#include "../gb/rewind.hpp"
+#include "rom.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstdlib>
+
+// Measures emulated frames per second for every cpu backend, how long
+// saving and restoring a state in memory takes, what recording frames for
+// rewinding costs, how many machines can be cloned per second and how
+// stepping a batch of machines scales with threads.
+//
+//   yagbe-bench [--frames N] [ROM]
+//
+// Without a rom a synthetic program is used.
+
+static double run(RomImage::handle_t const& rom, int frames, Backend::Kind backend)
+{
+  auto gb = std::make_unique<GB>();
+  if (not gb->backend(backend))
+    return 0.0;
+
+  gb->insert_rom(rom);
+  gb->power_on(true); // only the game is measured
+
+  auto const start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; ++i)
+    gb->run_frame();
+  auto const end = std::chrono::steady_clock::now();
+
+  return frames / std::chrono::duration<double>(end - start).count();
+}
+
+// microseconds per save and per restore
+static std::pair<double, double> run_states(RomImage::handle_t const& rom, size_t& size)
+{
+  static const int COUNT = 10000;
+
+  auto gb = std::make_unique<GB>();
+  gb->insert_rom(rom);
+  gb->power_on(true);
+  for (int i = 0; i < 60; ++i)
+    gb->run_frame();
+
+  std::vector<uint8_t> state;
+  gb->save_state(state);
+  size = state.size();
+
+  auto const start = std::chrono::steady_clock::now();
+  for (int i = 0; i < COUNT; ++i)
+    gb->save_state(state);
+  auto const saved = std::chrono::steady_clock::now();
+  for (int i = 0; i < COUNT; ++i)
+    gb->load_state(state);
+  auto const loaded = std::chrono::steady_clock::now();
+
+  return {
+    std::chrono::duration<double, std::micro>(saved - start).count() / COUNT,
+    std::chrono::duration<double, std::micro>(loaded - saved).count() / COUNT };
+}
+
+// microseconds per recorded frame, and the bytes it adds to the history
+static std::pair<double, double> run_rewind(RomImage::handle_t const& rom, int frames)
+{
+  auto gb = std::make_unique<GB>();
+  gb->insert_rom(rom);
+  gb->power_on(true);
+
+  Rewind rewind(SIZE_MAX);
+  std::chrono::steady_clock::duration spent{};
+  for (int i = 0; i < frames; ++i) {
+    gb->run_frame();
+
+    auto const start = std::chrono::steady_clock::now();
+    rewind.push(*gb);
+    spent += std::chrono::steady_clock::now() - start;
+  }
+
+  return {
+    std::chrono::duration<double, std::micro>(spent).count() / frames,
+    static_cast<double>(rewind.bytes()) / frames };
+}
+
+static double run_clones(RomImage::handle_t const& rom, Backend::Kind backend)
+{
+  static const int COUNT = 10000;
+
+  auto gb = std::make_unique<GB>();
+  if (not gb->backend(backend))
+    return 0.0;
+
+  gb->insert_rom(rom);
+  gb->power_on(true);
+  for (int i = 0; i < 60; ++i)
+    gb->run_frame();
+
+  auto const start = std::chrono::steady_clock::now();
+  for (int i = 0; i < COUNT; ++i)
+    gb->clone();
+  auto const end = std::chrono::steady_clock::now();
+
+  return COUNT / std::chrono::duration<double>(end - start).count();
+}
+
+// frames per second of all machines together
+static double run_batch(RomImage::handle_t const& rom, int steps, size_t threads)
+{
+  static const size_t COUNT = 64;
+
+  GB gb;
+  gb.insert_rom(rom);
+  gb.power_on(true);
+
+  Batch batch(gb, COUNT, threads);
+  batch.observe({ 0xC000, 0xFF44 });
+
+  std::vector<reg_t> buttons(COUNT);
+  for (int step = 0; step < steps; ++step) {
+    for (size_t i = 0; i < COUNT; ++i)
+      buttons[i] = (step / 8 + i) & 1 ? Input::BUTTON_START : 0;
+    batch.step(buttons.data());
+  }
+
+  return batch.frames_per_second();
+}
+
+int main(int argc, char** argv)
+{
+  int         frames = 600;
+  std::string rom_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--frames" and i + 1 < argc)
+      frames = std::atoi(argv[++i]);
+    else
+      rom_path = arg;
+  }
+
+  auto const rom = rom_path.empty()
+    ? RomImage::copy(SyntheticRom::make())
+    : RomImage::open(rom_path);
+
+  if (not rom)
+    return EXIT_FAILURE;
+
+  double reference = 0.0;
+  for (auto backend : { Backend::Kind::Reference, Backend::Kind::Cached, Backend::Kind::Jit }) {
+    auto const fps = run(rom, frames, backend);
+    if (backend == Backend::Kind::Reference)
+      reference = fps;
+
+    if (fps > 0.0)
+      printf("BENCH: %-9s %8.1f frames/s (x%.2f)\n", Backend::name(backend), fps, fps / reference);
+    else
+      printf("BENCH: %-9s not available\n", Backend::name(backend));
+  }
+
+  size_t size = 0;
+  auto const states = run_states(rom, size);
+  printf("BENCH: state     %8zu bytes, save %.2f us, load %.2f us\n", size, states.first, states.second);
+
+  auto const rewind = run_rewind(rom, frames);
+  printf(
+    "BENCH: rewind    %8.0f bytes/frame, %.2f us/frame (%.2f%% of 60 fps)\n",
+    rewind.second, rewind.first, rewind.first * 60.0 / 1e4);
+
+  for (auto backend : { Backend::Kind::Reference, Backend::Kind::Cached, Backend::Kind::Jit }) {
+    auto const clones = run_clones(rom, backend);
+    if (clones > 0.0)
+      printf("BENCH: clone     %8.0f clones/s (%s)\n", clones, Backend::name(backend));
+  }
+
+  auto const cores = std::max(std::thread::hardware_concurrency(), 1u);
+  double one_thread = 0.0;
+  for (size_t threads = 1; ; threads = std::min<size_t>(threads * 2, cores)) {
+    auto const fps = run_batch(rom, std::max(frames / 10, 1), threads);
+    if (threads == 1)
+      one_thread = fps;
+
+    printf("BENCH: batch     %8.0f frames/s, %zu threads (x%.2f)\n", fps, threads, fps / one_thread);
+    if (threads == cores)
+      break;
+  }
+
+  return EXIT_SUCCESS;
+}
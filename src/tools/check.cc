@@ -0,0 +1,221 @@
+#include "../gb/gb.hpp"
+#include "../gb/cheats.hpp"
+#include "../gb/movie.hpp"
+#include "../gb/rewind.hpp"
+#include "rom.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <stdio.h>
+
+// Checks of the features around the core that the lockstep comparison does
+// not cover, each on the synthetic program.
+//
+//   yagbe-check states|rewind|clone|movie|cheats
+//
+// Prints what failed and exits with a failure if anything did.
+
+static bool expect(bool ok, char const* what)
+{
+  if (not ok)
+    printf("CHECK: %s\n", what);
+
+  return ok;
+}
+
+static std::unique_ptr<GB> make_gb()
+{
+  static auto const rom = RomImage::copy(SyntheticRom::make());
+
+  auto gb = std::make_unique<GB>();
+  gb->insert_rom(rom);
+  gb->power_on(true);
+  return gb;
+}
+
+static std::vector<uint8_t> state(GB const& gb)
+{
+  std::vector<uint8_t> data;
+  gb.save_state(data);
+  return data;
+}
+
+static void run(GB& gb, int frames)
+{
+  for (int i = 0; i < frames; ++i)
+    gb.run_frame();
+}
+
+// a state loaded in between changes nothing about the frames after it,
+// one that cannot be loaded leaves the machine as it was
+static bool check_states()
+{
+  auto gb = make_gb();
+  run(*gb, 20);
+  auto const saved = state(*gb);
+  run(*gb, 30);
+  auto const later = state(*gb);
+
+  bool ok = expect(not gb->load_state(saved).is_set(), "state not loaded");
+  run(*gb, 30);
+  ok = expect(state(*gb) == later, "run after loading differs") and ok;
+
+  // header: magic, version, rom hash, size, cartridge ram size; the memory
+  // starts with the end of the boot rom after the cpu
+  StateWriter cp;
+  gb->cp().save_state(cp);
+  size_t const boot_end = 24 + cp.size();
+
+  auto const rejected = [&] (std::vector<uint8_t> const& bad, char const* what) {
+    auto const ok = expect(gb->load_state(bad).is_set(), what);
+    return expect(state(*gb) == later, "rejected state changed the machine") and ok;
+  };
+
+  auto truncated = saved;
+  truncated.pop_back();
+  ok = rejected(truncated, "truncated state loaded") and ok;
+
+  for (auto at : { size_t(0), size_t(4), size_t(8), size_t(16), size_t(20), boot_end }) {
+    auto edited = saved;
+    edited[at + 1] ^= 0x40;
+    ok = rejected(edited, ("state edited at " + std::to_string(at + 1) + " loaded").c_str()) and ok;
+  }
+
+  return ok;
+}
+
+// going back restores every frame exactly
+static bool check_rewind()
+{
+  auto gb = make_gb();
+  Rewind rewind;
+  std::vector<std::vector<uint8_t>> frames;
+
+  for (int i = 0; i < 30; ++i) {
+    rewind.push(*gb);
+    frames.push_back(state(*gb));
+    run(*gb, 1);
+  }
+
+  bool ok = true;
+  for (auto i = frames.size() - 1; i-- > 0;) {
+    ok = expect(rewind.pop(*gb), "rewind stopped early") and ok;
+    ok = expect(state(*gb) == frames[i], ("frame " + std::to_string(i) + " differs").c_str()) and ok;
+  }
+
+  return expect(not rewind.pop(*gb), "rewind went past the first frame") and ok;
+}
+
+// the clone shares nothing that either of them changes
+static bool check_clone()
+{
+  auto gb = make_gb();
+  run(*gb, 10);
+  auto const cloned = state(*gb);
+  auto clone = gb->clone();
+
+  run(*gb, 10);
+  bool ok = expect(state(*clone) == cloned, "source changed the clone");
+  run(*clone, 10);
+  ok = expect(state(*clone) == state(*gb), "clone runs differently") and ok;
+
+  // a patched rom byte and cartridge ram written by a cheat
+  ok = expect(not gb->add_cheat("AB1-50F").is_set(), "game genie code rejected") and ok;
+  ok = expect(not gb->add_cheat("80AB00A0").is_set(), "gameshark code rejected") and ok;
+  run(*gb, 1);
+  run(*clone, 1);
+
+  ok = expect(gb->mem(0x0150) == 0xAB and gb->ram()[0] == 0xAB, "cheats not applied") and ok;
+  return expect(clone->mem(0x0150) != 0xAB and clone->ram()[0] != 0xAB, "cheats reached the clone") and ok;
+}
+
+// a recording replays to the same screens, also after a round trip
+// through a file
+static bool check_movie()
+{
+  auto gb = make_gb();
+  Movie recorded;
+  recorded.start(*gb, true);
+
+  for (int i = 0; i < 60; ++i) {
+    reg_t const buttons = (i / 7) % 3 == 0 ? Input::BUTTON_START : 0;
+    gb->buttons(buttons);
+    gb->run_frame();
+    recorded.record(buttons, *gb);
+  }
+
+  auto const path = "yagbe-check.ygm";
+  bool ok = expect(not recorded.save(path).is_set(), "movie not saved");
+
+  Movie loaded;
+  ok = expect(not loaded.load(path).is_set(), "movie not loaded") and ok;
+  remove(path);
+
+  ok = expect(loaded.frames() == recorded.frames(), "frames lost") and ok;
+  for (size_t frame = 0; frame < recorded.frames(); ++frame) {
+    if (loaded.buttons(frame) != recorded.buttons(frame) or
+        loaded.screen(frame) != recorded.screen(frame))
+      ok = expect(false, ("frame " + std::to_string(frame) + " differs").c_str());
+  }
+
+  size_t mismatch = 0;
+  auto replay = make_gb();
+  ok = expect(not loaded.play(*replay, mismatch).is_set(), "movie not played") and ok;
+  return expect(mismatch == loaded.frames(), "replay shows other screens") and ok;
+}
+
+static bool check_code(char const* text, Cheats::Code::Kind kind, int addr, int value, int compare, int bank)
+{
+  Cheats::Code code;
+  auto const valid = not Cheats::parse(text, code).is_set();
+
+  return expect(
+    valid and code.kind == kind and code.addr == addr and code.value == value and
+    code.compare == compare and code.bank == bank,
+    (std::string(text) + " decoded wrong").c_str());
+}
+
+static bool check_cheats()
+{
+  using Kind = Cheats::Code::Kind;
+
+  bool ok = check_code("00A-17B", Kind::GameGenie, 0x4A17, 0x00, -1, -1);
+  ok = check_code("3E8-2DF-E6E", Kind::GameGenie, 0x082D, 0x3E, 0x01, -1) and ok;
+  ok = check_code("010238CD", Kind::GameShark, 0xCD38, 0x02, -1, -1) and ok;
+  ok = check_code("83FF00A0", Kind::GameShark, 0xA000, 0xFF, -1, 3) and ok;
+
+  Cheats::Code code;
+  for (auto text : { "", "0102", "XYZ-123", "00A-17B-C", "020238CD" })
+    ok = expect(Cheats::parse(text, code).is_set(), (std::string(text) + " accepted").c_str()) and ok;
+
+  Cheats cheats;
+  ok = expect(cheats.add("83FF00A0", 0x6000).is_set(), "code for a missing ram bank accepted") and ok;
+  return expect(not cheats.add("83FF00A0", 0x8000).is_set(), "code for ram bank 3 rejected") and ok;
+}
+
+int main(int argc, char** argv)
+{
+  std::string const check = argc > 1 ? argv[1] : "";
+
+  bool ok = false;
+  if (check == "states")
+    ok = check_states();
+  else if (check == "rewind")
+    ok = check_rewind();
+  else if (check == "clone")
+    ok = check_clone();
+  else if (check == "movie")
+    ok = check_movie();
+  else if (check == "cheats")
+    ok = check_cheats();
+  else {
+    printf("usage: yagbe-check states|rewind|clone|movie|cheats\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("CHECK: %-8s %s\n", check.c_str(), ok ? "ok" : "FAILED");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,462 @@
+#include "../gb/gb.hpp"
+#include "../gb/hash.hpp"
+#include "opcode_hashes.hpp"
+#include "rom.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+// Runs a game on the reference backend and on a fast one in lockstep and
+// stops at the first point where they disagree.
+//
+//   yagbe-diff [--backend cached|jit] [--frames N] [--seeds N] [--fast]
+//              [--verify] [ROM]
+//
+// Registers and the memory pages written since the last check are compared
+// whenever the fast backend is between instructions, with --fast only once
+// per frame. All of memory and the screen are compared once per frame.
+// --verify also has the jit check every translation against the
+// interpreter before it first runs and fails if any disagreed.
+// Without a rom the synthetic programs for seeds 1..N are run, with and
+// without interrupts. Exits with a failure if anything diverged.
+//
+//   yagbe-diff --opcodes
+//
+// Runs each of the 512 instructions on its own and compares what it leaves
+// behind with the hashes in opcode_hashes.hpp.
+
+class Lockstep
+{
+public:
+  static constexpr size_t HISTORY = 16;
+
+  Lockstep(RomImage::handle_t const& rom, Backend::Kind backend)
+    : _ref(std::make_unique<GB>())
+    , _opt(std::make_unique<GB>())
+  {
+    _ref->backend(Backend::Kind::Reference);
+    _available = _opt->backend(backend);
+
+    for (auto& gb : { _ref.get(), _opt.get() }) {
+      gb->insert_rom(rom);
+      gb->power_on(true); // synthetic programs have no header to boot
+    }
+  }
+
+  bool available() const
+  {
+    return _available;
+  }
+
+  void verify()
+  {
+    _opt->jit_verify(true);
+  }
+
+  // translations that disagreed with the interpreter
+  uint64_t mismatches() const
+  {
+    auto const* stats = _opt->jit_stats();
+    return stats ? stats->mismatches : 0;
+  }
+
+  // true if both agreed for all frames
+  bool run(int frames, bool fast)
+  {
+    for (_frame = 0; _frame < frames; ++_frame) {
+      do {
+        if (not _tick())
+          return false;
+
+        if (not fast and _opt->cp().busy_cycles() == 0 and not _compare_step())
+          return false;
+      }
+      while (not _opt->is_v_blank_completed());
+
+      if (not _sync() or not _compare_frame())
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  bool _tick()
+  {
+    auto const& cp = _ref->cp();
+    if (cp.busy_cycles() == 0 and not cp.halted()) {
+      auto& ins = _history[_executed++ % HISTORY];
+      ins.pc = cp.pc();
+      for (size_t i = 0; i < ins.bytes.size(); ++i)
+        ins.bytes[i] = _ref->mem(cp.pc() + i);
+    }
+
+    _ref->tick();
+    _opt->tick();
+
+    if (_ref->is_v_blank_completed() != _opt->is_v_blank_completed())
+      return _report("frame timing");
+
+    return true;
+  }
+
+  // the fast backends charge whole blocks and loops at once, so both are
+  // only comparable while the fast one is between instructions
+  bool _sync()
+  {
+    for (int i = 0; i < 0x100000; ++i) {
+      if (_opt->cp().busy_cycles() == 0)
+        return true;
+
+      if (not _tick())
+        return false;
+    }
+
+    return _report("never between instructions");
+  }
+
+  bool _compare_cpu()
+  {
+    auto const& r = _ref->cp();
+    auto const& o = _opt->cp();
+
+    if (r.pc() != o.pc() or r.sp() != o.sp() or
+        r.af() != o.af() or r.bc() != o.bc() or
+        r.de() != o.de() or r.hl() != o.hl() or
+        r.ime() != o.ime() or r.halted() != o.halted() or
+        r.busy_cycles() != o.busy_cycles())
+      return _report("registers");
+
+    if (_ref->mm().bank(0x4000) != _opt->mm().bank(0x4000))
+      return _report("rom bank");
+
+    return true;
+  }
+
+  bool _compare_mem(wide_reg_t from, uint32_t to)
+  {
+    for (uint32_t addr = from; addr < to; ++addr) {
+      auto const r = _ref->mem(addr);
+      auto const o = _opt->mem(addr);
+      if (r != o) {
+        printf("DIFF: memory %04x reference:%02x fast:%02x\n", addr, r, o);
+        return _report("memory");
+      }
+    }
+
+    return true;
+  }
+
+  bool _compare_step()
+  {
+    if (not _compare_cpu())
+      return false;
+
+    for (uint32_t page = 0x80; page < 0x100; ++page) {
+      auto const addr = static_cast<wide_reg_t>(page << 8);
+      auto const r = _ref->mm().page_version(addr);
+      auto const o = _opt->mm().page_version(addr);
+      if (r == _ref_pages[page] and o == _opt_pages[page])
+        continue;
+
+      _ref_pages[page] = r;
+      _opt_pages[page] = o;
+
+      if (not _compare_mem(addr, addr + 0x100))
+        return false;
+    }
+
+    return true;
+  }
+
+  bool _compare_frame()
+  {
+    if (not _compare_cpu() or not _compare_mem(0x0000, 0x10000))
+      return false;
+
+    if (_ref->screen() != _opt->screen())
+      return _report("screen");
+
+    return true;
+  }
+
+  bool _report(char const* what)
+  {
+    printf("DIFF: %s differ in frame %d after %llu instructions\n",
+      what, _frame, static_cast<unsigned long long>(_executed));
+
+    for (auto& gb : { _ref.get(), _opt.get() }) {
+      auto const& cp = gb->cp();
+      printf(
+        "DIFF: %-9s pc:%04x sp:%04x af:%04x bc:%04x de:%04x hl:%04x ime:%d halted:%d busy:%u bank:%u\n",
+        Backend::name(gb->backend()),
+        cp.pc(), cp.sp(), cp.af(), cp.bc(), cp.de(), cp.hl(),
+        cp.ime(), cp.halted(), cp.busy_cycles(), gb->mm().bank(0x4000));
+    }
+
+    auto const n = std::min<uint64_t>(_executed, HISTORY);
+    for (auto i = _executed - n; i < _executed; ++i) {
+      auto const& ins = _history[i % HISTORY];
+      auto const len = Opcodes::length(ins.bytes[0]);
+
+      printf("DIFF:   %04x ", ins.pc);
+      for (size_t b = 0; b < ins.bytes.size(); ++b) {
+        if (b < len)
+          printf(" %02x", ins.bytes[b]);
+        else
+          printf("   ");
+      }
+      printf("  %s\n", Opcodes::name(ins.bytes[0], ins.bytes[1]));
+    }
+
+    return false;
+  }
+
+  struct Ins
+  {
+    wide_reg_t           pc;
+    std::array<reg_t, 3> bytes;
+  };
+
+  std::unique_ptr<GB>           _ref;
+  std::unique_ptr<GB>           _opt;
+  bool                          _available = false;
+  int                           _frame     = 0;
+  uint64_t                      _executed  = 0;
+  std::array<Ins, HISTORY>      _history   = {};
+  std::array<uint32_t, 0x100>   _ref_pages = {};
+  std::array<uint32_t, 0x100>   _opt_pages = {};
+};
+
+// Runs every instruction, CB prefixed ones included, from registers and
+// memory made up from a seed and hashes what it leaves behind: registers,
+// cycles and every byte it could have written. Pointers are kept in work
+// and high ram, so nothing depends on i/o.
+class OpcodeSweep
+{
+public:
+  static constexpr wide_reg_t AT = 0xC000;
+
+  OpcodeSweep()
+    : _cp(_mm)
+  {
+    _cp.backend(std::make_unique<ReferenceBackend>(_cp, _mm));
+    _mm.insert_rom(mem_t(0x8000, 0));
+  }
+
+  // index n is opcode n, 0x100 + n is CB n
+  std::array<uint64_t, 0x200> run(int seeds)
+  {
+    std::array<std::vector<reg_t>, 0x200> results;
+
+    for (int seed = 1; seed <= seeds; ++seed) {
+      _state = seed;
+      _mm.power_on(false);
+      _fill(0xC000, 0xE000);
+      _fill(0xFF80, 0xFFFF);
+
+      for (size_t i = 0; i < results.size(); ++i)
+        _run(i, results[i]);
+    }
+
+    std::array<uint64_t, 0x200> hashes;
+    for (size_t i = 0; i < results.size(); ++i)
+      hashes[i] = hash(results[i].data(), results[i].size());
+
+    return hashes;
+  }
+
+private:
+  void _run(size_t i, std::vector<reg_t>& result)
+  {
+    reg_t const op = i < 0x100 ? i : 0xCB;
+    reg_t b1 = i < 0x100 ? _rand() : i & 0xFF;
+    reg_t b2 = _rand();
+
+    _cp.power_on(false);
+    _cp.pc(AT);
+    _cp.a() = _rand();
+    _cp.f() = _rand() & 0xF0;
+    _cp.bc(_pointer());
+    _cp.de(_pointer());
+    _cp.hl(_pointer());
+    _cp.sp(_pointer() | 0x0100);
+
+    if (op == 0xE0 or op == 0xF0)   // LD (n),A  LD A,(n)
+      b1 = 0x80 + _rand() % 0x7F;
+    if (op == 0xE2 or op == 0xF2)   // LD (C),A  LD A,(C)
+      _cp.c() = 0x80 + _rand() % 0x7F;
+    if (op == 0x08 or op == 0xEA or op == 0xFA)
+      b2 = 0xC0 + _rand() % 0x1F;   // LD (nn),SP  LD (nn),A  LD A,(nn)
+
+    _mm.write(AT, op);
+    _mm.write(AT + 1, b1);
+    _mm.write(AT + 2, b2);
+
+    auto const nn = static_cast<wide_reg_t>((b2 << 8) | b1);
+    wide_reg_t const written[] = {
+      AT, AT + 1, AT + 2, _cp.bc(), _cp.de(), _cp.hl(),
+      static_cast<wide_reg_t>(_cp.sp() - 2), static_cast<wide_reg_t>(_cp.sp() - 1),
+      nn, static_cast<wide_reg_t>(nn + 1),
+      static_cast<wide_reg_t>(0xFF00 + b1), static_cast<wide_reg_t>(0xFF00 + _cp.c()) };
+
+    _cp.tick();
+
+    auto const& cp = _cp;
+    for (auto const r : { cp.a(), cp.b(), cp.c(), cp.d(), cp.e(), cp.f(), cp.h(), cp.l() })
+      result.push_back(r);
+    for (auto const w : { cp.sp(), cp.pc() }) {
+      result.push_back(w);
+      result.push_back(w >> 8);
+    }
+    result.push_back(cp.ime());
+    result.push_back(cp.halted());
+    result.push_back(cp.busy_cycles());
+
+    for (auto const addr : written) {
+      if (not _in_ram(addr))
+        continue;
+
+      result.push_back(_mm.read(addr));
+      _mm.write(addr, _ram[addr]);
+    }
+  }
+
+  static bool _in_ram(wide_reg_t addr)
+  {
+    return (addr >= 0xC000 and addr < 0xE000) or (addr >= 0xFF80 and addr < 0xFFFF);
+  }
+
+  void _fill(uint32_t from, uint32_t to)
+  {
+    for (auto addr = from; addr < to; ++addr) {
+      _ram[addr] = _rand();
+      _mm.write(addr, _ram[addr]);
+    }
+  }
+
+  // somewhere in work ram, below the echo
+  wide_reg_t _pointer()
+  {
+    auto const high = 0xC0 + _rand() % 0x1F;
+    return (high << 8) | _rand();
+  }
+
+  reg_t _rand()
+  {
+    _state = _state * 1103515245 + 12345;
+    return _state >> 16;
+  }
+
+  MM                         _mm;
+  CP                         _cp;
+  std::array<reg_t, 0x10000> _ram   = {}; // what work and high ram were filled with
+  uint32_t                   _state = 0;
+};
+
+static bool run_opcodes()
+{
+  auto const hashes = OpcodeSweep().run(OPCODE_SEEDS);
+
+  bool same = true;
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    if (hashes[i] == OPCODE_HASHES[i])
+      continue;
+
+    printf(
+      "DIFF: %s%02zx %-12s expected:%016llx got:%016llx\n",
+      i < 0x100 ? "" : "cb ",
+      i & 0xFF,
+      i < 0x100 ? Opcodes::name(i, 0) : Opcodes::name(0xCB, i & 0xFF),
+      static_cast<unsigned long long>(OPCODE_HASHES[i]),
+      static_cast<unsigned long long>(hashes[i]));
+    same = false;
+  }
+
+  printf("DIFF: %-20s %s\n", "opcodes", same ? "ok" : "FAILED");
+  return same;
+}
+
+static bool run(
+  char const* name, RomImage::handle_t const& rom, Backend::Kind backend,
+  int frames, bool fast, bool verify)
+{
+  Lockstep lockstep(rom, backend);
+  if (not lockstep.available()) {
+    printf("DIFF: %s not available\n", Backend::name(backend));
+    return true;
+  }
+
+  if (verify)
+    lockstep.verify();
+
+  auto same = lockstep.run(frames, fast);
+  if (auto const mismatches = lockstep.mismatches()) {
+    printf("DIFF: %llu translations disagree\n", static_cast<unsigned long long>(mismatches));
+    same = false;
+  }
+
+  printf("DIFF: %-20s %s\n", name, same ? "ok" : "FAILED");
+  return same;
+}
+
+int main(int argc, char** argv)
+{
+  Backend::Kind backend = Backend::Kind::Cached;
+  int           frames  = 60;
+  int           seeds   = 4;
+  bool          fast    = false;
+  bool          verify  = false;
+  bool          opcodes = false;
+  std::string   rom_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--backend" and i + 1 < argc) {
+      if (not Backend::parse(argv[++i], backend)) {
+        printf("unknown backend %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (arg == "--frames" and i + 1 < argc)
+      frames = std::atoi(argv[++i]);
+    else if (arg == "--seeds" and i + 1 < argc)
+      seeds = std::atoi(argv[++i]);
+    else if (arg == "--fast")
+      fast = true;
+    else if (arg == "--verify")
+      verify = true;
+    else if (arg == "--opcodes")
+      opcodes = true;
+    else
+      rom_path = arg;
+  }
+
+  if (opcodes)
+    return run_opcodes() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  bool same = true;
+
+  if (not rom_path.empty()) {
+    auto const rom = RomImage::open(rom_path);
+    if (not rom)
+      return EXIT_FAILURE;
+
+    same = run(rom_path.c_str(), rom, backend, frames, fast, verify);
+  }
+  else {
+    for (int seed = 1; seed <= seeds; ++seed) {
+      for (bool interrupts : { false, true }) {
+        auto const name =
+          "seed " + std::to_string(seed) + (interrupts ? " irq" : "");
+        auto const rom = RomImage::copy(SyntheticRom::make(seed, interrupts));
+        same = run(name.c_str(), rom, backend, frames, fast, verify) and same;
+      }
+    }
+  }
+
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,165 @@
+#include "../gb/gb.hpp"
+#include "../gb/movie.hpp"
+#include "rom.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <cstdlib>
+
+// Runs a game without a window as fast as possible, for servers and ci.
+//
+//   yagbe-headless [--frames N | --cycles N] [--backend K] [--fast-boot]
+//                  [--cheat CODE]... [--movie FILE] [--hashes]
+//                  [--dump FILE] [ROM]
+//
+// --frames defaults to 600, or to the length of the movie. --cycles runs
+// whole frames until at least N cpu ticks passed. A movie supplies the
+// input, its power on and cheats, and every screen is checked against it.
+// --hashes prints a hash of every frame, --dump appends every frame to FILE
+// as 160x144 bytes of shades 0 to 3. Without a rom the synthetic program of
+// the other tools is run. Exits with a failure if a screen differs from the
+// movie.
+
+int main(int argc, char** argv)
+{
+  size_t        frames    = 0;
+  uint64_t      cycles    = 0;
+  Backend::Kind backend   = Backend::Kind::Cached;
+  bool          fast_boot = false;
+  bool          hashes    = false;
+  std::string   movie_path;
+  std::string   dump_path;
+  std::string   rom_path;
+
+  std::vector<std::string> cheats;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--frames" and i + 1 < argc)
+      frames = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--cycles" and i + 1 < argc)
+      cycles = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--fast-boot")
+      fast_boot = true;
+    else if (arg == "--cheat" and i + 1 < argc)
+      cheats.push_back(argv[++i]);
+    else if (arg == "--movie" and i + 1 < argc)
+      movie_path = argv[++i];
+    else if (arg == "--hashes")
+      hashes = true;
+    else if (arg == "--dump" and i + 1 < argc)
+      dump_path = argv[++i];
+    else if (arg == "--backend" and i + 1 < argc) {
+      if (not Backend::parse(argv[++i], backend)) {
+        printf("unknown backend %s (reference, cached or jit)\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    else
+      rom_path = arg;
+  }
+
+  // synthetic programs have no header to boot
+  auto const rom = rom_path.empty()
+    ? RomImage::copy(SyntheticRom::make())
+    : RomImage::open(rom_path);
+  fast_boot = fast_boot or rom_path.empty();
+
+  GB gb;
+  if (not gb.backend(backend))
+    printf("BACKEND: %s not available on this platform\n", Backend::name(backend));
+
+  auto const error = gb.insert_rom(rom);
+  if (error.is_set()) {
+    printf("%s\n", error.text().c_str());
+    return EXIT_FAILURE;
+  }
+
+  Movie movie;
+  bool const playing = not movie_path.empty();
+  if (playing) {
+    auto const load_error  = movie.load(movie_path);
+    auto const movie_error = load_error.is_set() ? load_error : movie.power_on(gb);
+    if (movie_error.is_set()) {
+      printf("MOVIE: %s %s\n", movie_error.text().c_str(), movie_path.c_str());
+      return EXIT_FAILURE;
+    }
+
+    if (not frames or frames > movie.frames())
+      frames = movie.frames();
+  }
+  else {
+    gb.power_on(fast_boot);
+    for (auto const& cheat : cheats) {
+      auto const cheat_error = gb.add_cheat(cheat);
+      if (cheat_error.is_set())
+        printf("CHEAT: %s %s\n", cheat.c_str(), cheat_error.text().c_str());
+    }
+  }
+
+  if (not frames)
+    frames = cycles ? std::numeric_limits<size_t>::max() : 600;
+  if (not cycles)
+    cycles = std::numeric_limits<uint64_t>::max();
+
+  std::ofstream dump;
+  bool const dumping = not dump_path.empty();
+  if (dumping) {
+    dump.open(dump_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (not dump) {
+      printf("DUMP: %s\n", Error(Error::Code::FileNotAccessible).text().c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto const first_cycle = gb.cp().cycle();
+  auto const start = std::chrono::steady_clock::now();
+
+  size_t frame = 0;
+  bool   same  = true;
+  while (same and frame < frames and gb.cp().cycle() - first_cycle < cycles) {
+    if (playing)
+      gb.buttons(movie.buttons(frame));
+
+    gb.run_frame();
+
+    if (playing or hashes) {
+      auto const hash = Movie::screen_hash(gb);
+      if (hashes)
+        printf("FRAME: %zu %016llx\n", frame, static_cast<unsigned long long>(hash));
+
+      if (playing and hash != movie.screen(frame)) {
+        printf("MOVIE: frame %zu differs from the recording\n", frame);
+        same = false;
+      }
+    }
+
+    if (dumping) {
+      auto const& screen = gb.screen();
+      dump.write(reinterpret_cast<char const*>(screen.data()), screen.size());
+    }
+
+    ++frame;
+  }
+
+  auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  auto const ran     = gb.cp().cycle() - first_cycle;
+
+  printf(
+    "HEADLESS: %zu frames, %llu cycles in %.3f s, %.1f frames/s (x%.2f), %.2f MHz\n",
+    frame,
+    static_cast<unsigned long long>(ran),
+    seconds,
+    frame / seconds,
+    frame / seconds / 60.0,
+    ran / seconds / 1e6);
+
+  if (dumping and not dump.flush()) {
+    printf("DUMP: %s\n", Error(Error::Code::FileNotAccessible).text().c_str());
+    return EXIT_FAILURE;
+  }
+
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// What yagbe-diff --opcodes hashes for every instruction, recorded while
+// the handlers were still written out one by one instead of generated from
+// the bit fields of the encoding. Index n is opcode n, 0x100 + n is CB n.
+static constexpr int OPCODE_SEEDS = 16;
+
+static constexpr std::array<uint64_t, 0x200> OPCODE_HASHES = {{
+  0xa14839da3a2e3906ull, 0x506649707215c810ull, 0x14d9e578a4588ea3ull, 0x5166c76ff4ae73aaull, // 00
+  0x3b22cab0cbbf03bdull, 0xf4c4572ea953dc8full, 0xf0aacfb3cc4530cfull, 0x3f6e7fbadf3ca2e7ull, // 04
+  0xf5792b51d8577f92ull, 0x77ed6214bc5880bfull, 0x8823a425fa9e6ddbull, 0xa46e9d38886b724full, // 08
+  0xb8e894217757626cull, 0x2f14a9e98f78e00eull, 0x4143300b7707152aull, 0x549b7a11a0315531ull, // 0c
+  0xa5bd82cdd55bcd0dull, 0x0449479d29fcb52aull, 0x174919bb372cdfecull, 0x64a2fd9dc4edd52aull, // 10
+  0x045be59457ba2781ull, 0x45580918fcf7ec60ull, 0xc191266e4a1e324aull, 0x9d65f3ec7fa9c514ull, // 14
+  0x49c95b320f84e1bbull, 0x42a6a861f549c485ull, 0x0b59b5aff4d3a262ull, 0x6a3f3b841ae23321ull, // 18
+  0x69a27d13dcbb10b4ull, 0xb5eb1062f156f055ull, 0xff9e6a9a86c53df3ull, 0xc967b3e663511b54ull, // 1c
+  0xb8e4deaf2f6c240eull, 0xc06c2733c1add478ull, 0xdd2f147aaeb37ebdull, 0x05dd06b665fdb533ull, // 20
+  0x94c571589c18e242ull, 0x7a38b35701553c3cull, 0x0a598181819d8204ull, 0xa9478e01c1b891eaull, // 24
+  0xe027427565dcedfdull, 0xddf13d569ec5d6f2ull, 0x9b7d3f0c58f3ad51ull, 0x5a763480ff424ebeull, // 28
+  0x535c936e7a4d0cc2ull, 0xa609d94e6557bd6full, 0xf797c705ba5dc816ull, 0xfed2f839ecb872d8ull, // 2c
+  0x02539523eeaa2854ull, 0x77ce5ea0d781aaf5ull, 0xb7d612e0575d6c96ull, 0xae560b7aec8c7d33ull, // 30
+  0x9bfffa901a7f1e44ull, 0x07e40f30eaef9852ull, 0xc35784404a9ecb53ull, 0x63c0562700a35536ull, // 34
+  0x1d9b48ba07eb18cfull, 0x4f529422de8c715bull, 0x522b32c141812023ull, 0xe0c5f3126c315a7aull, // 38
+  0x051c47427f48c59bull, 0x81337347d485ff5full, 0x68cbf1ca5aa4b3b0ull, 0x78adf25a8bc32cd9ull, // 3c
+  0xbc350422be75d48eull, 0x767a6eeb9f33e326ull, 0x474ba0e8017cb190ull, 0x00ec9b93bd6485f6ull, // 40
+  0x80baa1db889d8ebfull, 0x2d55c68de908585bull, 0x079e462b1f930e1aull, 0x15b9960197000b04ull, // 44
+  0xe4db95fd082f568cull, 0xdbde9ca637e08c63ull, 0xb4f3673251517b6aull, 0x74e530a870bfd7ccull, // 48
+  0x4146cf1675e76f9dull, 0x84f0fde202f234f5ull, 0xdea7a785d99bf207ull, 0xc634e170b673f756ull, // 4c
+  0xd87913940aaada84ull, 0x3fdcba36608f554full, 0x5f9e6fc8f67e3b29ull, 0x866b42c2c9a7f463ull, // 50
+  0xa87b4cc1fa5683ecull, 0x470f09800c7db555ull, 0x3b9878a98255b1eaull, 0x1107c22393c1e762ull, // 54
+  0xf43a0cb517cf06feull, 0x252309ef3b5bd0c9ull, 0x61087351a3f5a88eull, 0x67f4c1de1cd0bf0cull, // 58
+  0x1fe5d990713b3e85ull, 0x1afb870af9071e83ull, 0xd35d0b7b91d07120ull, 0xaec32b9be2896787ull, // 5c
+  0xa97a2552162497d9ull, 0x46c9ea8700eb6bbfull, 0x52b3ff21980388e6ull, 0xf558380510350684ull, // 60
+  0xe3ad551bb47f3fe3ull, 0x39622800035cc833ull, 0x7f09fa91db65d762ull, 0x7f080e4b6d3c99f2ull, // 64
+  0xfc9def28706a4968ull, 0x28e598442d9d616dull, 0x66760dfda4459815ull, 0x0fb9b9150e9f71a1ull, // 68
+  0xdfaf93b1d3e2942bull, 0x3755d7c12c2b424cull, 0x48cbb1a94e419a66ull, 0x822ebcf921e1198cull, // 6c
+  0x7ced381ad53ea766ull, 0xdcd19735b8d22e3bull, 0x7b4fef32b6b9c1a3ull, 0x7549f14d0a2062c7ull, // 70
+  0x8082b0f11c2ff27eull, 0x5469c853ab1fe6ebull, 0x1d9ffb01b99b3df3ull, 0xdd4fbcd58fe60972ull, // 74
+  0x229b221584e54cfbull, 0x8220ed3bb38a81b4ull, 0xb145e4b397fe8851ull, 0x9b4a6296b6c2f43cull, // 78
+  0xbfaab8b33bcd6f3dull, 0x3a23fb2137edeadfull, 0x7da7a6388254752eull, 0x631732247b5a70b7ull, // 7c
+  0xaedbf969a0d06b3cull, 0x30aafba81e07214eull, 0x7994b8ee6e8ed6b0ull, 0x277afd7b3548139full, // 80
+  0xdeec697c99acb44aull, 0xd2b6c8278026d7bdull, 0xb910e4d612cc8dc5ull, 0x4f6e504ff602356eull, // 84
+  0xaea827a28695c134ull, 0xd68dff8af57da7c1ull, 0x3a41cd82e23939abull, 0x16bc34d88e65a941ull, // 88
+  0x7812fe4233b1bd17ull, 0x1e89f9dcd5143abbull, 0xbe1654ba53cbbb4dull, 0x7a93434fe81163dbull, // 8c
+  0xfe6e5bd7d7398ad0ull, 0x42d5db479488c352ull, 0xab82516399df019bull, 0x1a5a283712d7e35bull, // 90
+  0xba9168d80f1d9d78ull, 0x0b491390bed55ea3ull, 0xc090951c63955002ull, 0x90738d28f2b868f9ull, // 94
+  0x4ca51078d504742full, 0x67303993a4991486ull, 0xff5e636fa37e1bc7ull, 0xaa026fd03e38924dull, // 98
+  0xfe0a86fe74ae9db0ull, 0x03a6eef52b6ca9b9ull, 0x73fd151686032e1dull, 0x589324132a776abfull, // 9c
+  0xb8cfec3495444505ull, 0x8a54b192434acb69ull, 0xb4526c526f643e7bull, 0xa3d8d4a599b376bbull, // a0
+  0x0c569cf58a9fe7e5ull, 0xa2e0ed8113976192ull, 0xa7ac32df4eebc5deull, 0x05894ffbf31036a2ull, // a4
+  0x1cfeff3e98feaa6cull, 0xc7d76b6934fb1e21ull, 0x407f8eec47af50acull, 0x2397f7e45802de0bull, // a8
+  0xc07211e1b0780f8dull, 0x447ead280642858aull, 0xaa638c0ddb32cb4cull, 0x7d866e59ce7d9915ull, // ac
+  0x7d9a06895226afaeull, 0x8dcc2f2407c8203full, 0xd8d061010d6968f9ull, 0x5a3b76b619291163ull, // b0
+  0xbf43e58a68773d70ull, 0x19bb881f15003439ull, 0x851bffeff7101eabull, 0x2051a250ffe82975ull, // b4
+  0xb5c6087466a744bcull, 0x7296ed8784c7efe0ull, 0xd31a020d2d37b60aull, 0x2a1cd3fecb5b1338ull, // b8
+  0x24395d11c67b59f5ull, 0x678f130fe442154cull, 0xd82662d4405b9a98ull, 0x154c355a8fec1f72ull, // bc
+  0x10f9ad521e76304cull, 0x2a6a73a68b70e64full, 0xfb576669a25367d0ull, 0x634e4a5f4b9a77c4ull, // c0
+  0xbebab71b1c910d11ull, 0x02e8805c6695c7f1ull, 0x25af5949e678fa1full, 0x85479873feae5430ull, // c4
+  0x233b79a105dc4068ull, 0xe86f01b104eed6ecull, 0x53594ce77494a43aull, 0xb7dfe4f35d31a93cull, // c8
+  0xc37993a9c780c318ull, 0xce44e6bbbcc4d072ull, 0xb972664d37af2dbaull, 0xf815d6ec17a19bf1ull, // cc
+  0xf7d209b8045a15b0ull, 0x7175b47e6bcc6831ull, 0xaf56eefdc9ff531aull, 0xf4bc7cbe80889c53ull, // d0
+  0x68a6421d785baa05ull, 0x8de9f6d3c81c4fd4ull, 0x57f0715715616c76ull, 0x9cbb64253eb52d36ull, // d4
+  0x66ecd647ff35a0d8ull, 0xcc871a939de38f77ull, 0x5aa9d31c0ddeb243ull, 0xcb2170b6608f50d6ull, // d8
+  0x18e79dc725ea8a3bull, 0xbf8b3e8ae260daaeull, 0xc43bd9eda93894e1ull, 0xee112cb99763cdf4ull, // dc
+  0x463cab79e9c19f23ull, 0x659a12414800b9beull, 0x933e63ecc7531984ull, 0x6e3a0bb0bd4618e3ull, // e0
+  0xebe3fd4f85efd105ull, 0x7086eaa490ec4cbcull, 0x4f5a17f2ccd15196ull, 0x6edb6357e43bc926ull, // e4
+  0x39e0a90306c3fa4full, 0x5babb384c06aa718ull, 0x9c55ff871976d0c5ull, 0xbfbc175d756969b5ull, // e8
+  0xa3201831ad8790f9ull, 0xe76ca15cf22a7205ull, 0xd4ca63297af49196ull, 0x734ec1891c868810ull, // ec
+  0xa6a1237293377c98ull, 0x95cc29d0d08625c2ull, 0x60dd24b26fa577f5ull, 0x493f8a1188941fddull, // f0
+  0x1603cae3c2a6fdf3ull, 0x51086e7280fa64bdull, 0x70e07cf2844d18f2ull, 0x31d442db4f711297ull, // f4
+  0x579f6c3f3bc60226ull, 0x3b4698d71004bd56ull, 0x2fd29e10aa608d56ull, 0x20a6ba88f6e9a2c2ull, // f8
+  0xa9e076dd8ed72737ull, 0xf17e86d9f4e7876aull, 0x210ab763f787020aull, 0xbb7a5ebff3847f27ull, // fc
+  0xffa97c1d7e4b7a46ull, 0x7f1af782474b8f4dull, 0xbacf72b1fa7391a7ull, 0xc96390652ddb51c7ull, // cb 00
+  0xe7964703faff032eull, 0xd818a08501df8589ull, 0x37333592655ff5a3ull, 0x23cc42f3a793b2bdull, // cb 04
+  0x6a84126c6613b5dbull, 0x576f03c36809b827ull, 0x50f9943fa1457175ull, 0x3d8a4df082abd34cull, // cb 08
+  0xb5148d19e32071e2ull, 0x9f5325071321617dull, 0x3102aaee22e30f7dull, 0x0f29b06b409f7d7cull, // cb 0c
+  0xa713532014b0f5c3ull, 0x1a155f893a88fbffull, 0x810d703d034d9b68ull, 0x3a58486a383842a4ull, // cb 10
+  0x8ce7146997e36547ull, 0x07651d74d8fb2371ull, 0xe9e927ea01153221ull, 0xee0c8afebcc6802full, // cb 14
+  0x4b96aaf18157a5f6ull, 0xfabf9f588fb14be7ull, 0xa176cfed4654bf6cull, 0x1804d88d707812f1ull, // cb 18
+  0xf0e202fd0d598263ull, 0xdf5af0f55bdee872ull, 0x805d8548d1c0f1c6ull, 0xc817ae283eab91acull, // cb 1c
+  0x59edf2ced4b012e3ull, 0xf58141da4a8d0457ull, 0x9587aa9169b4e122ull, 0x52d571c799addeedull, // cb 20
+  0x832ad00966a6f128ull, 0xcd8a5a6c9e358937ull, 0xd853de38aed89704ull, 0xe3af6973fcdea21dull, // cb 24
+  0x08c535fd7af28c3eull, 0x51431319afcfbe16ull, 0x4d7c031e74192dceull, 0xf6572d229ef02175ull, // cb 28
+  0x814673b8fd8e548cull, 0x67f52cc428055753ull, 0xffc1ee0097c24bd2ull, 0xb68e4651d3ba4860ull, // cb 2c
+  0xd3760bc1d29c6c4dull, 0x4c72c59c1fbd58e1ull, 0xb8639adb1fd120bbull, 0x96fdb288df1c541dull, // cb 30
+  0x461b051bf412a4dbull, 0xa98dbec11b908549ull, 0x91ef9fd54f872f62ull, 0x1c3b5182d399d249ull, // cb 34
+  0xe07a70b02a453a9full, 0xd4408be75114da6eull, 0x67ee31ca6e4d35bfull, 0xdb8fd60f6944b3b5ull, // cb 38
+  0xbe1ce387448a9175ull, 0x9a900b759953b16full, 0xde12db3472e27a2eull, 0xe61d57ee4a26e879ull, // cb 3c
+  0xa6036709eebee52bull, 0x6cf3797d9130f11cull, 0x2d1a2911c4f18156ull, 0x8af8326e495b0555ull, // cb 40
+  0x8b5d0a2bf660a6b4ull, 0xb391bfdc73fa76cbull, 0x76efcc31f39c5d0eull, 0x7c2e523475376532ull, // cb 44
+  0x827f2b799f7e8cb8ull, 0x6a70985dd82d039bull, 0x3a8d1b90407709a2ull, 0x5a3233da32e0e9f1ull, // cb 48
+  0x902100855eb6294aull, 0xca3373d75f1fe195ull, 0xf007d9483246a992ull, 0x33598199afbcfdaeull, // cb 4c
+  0x021ee8562e8c2a11ull, 0x8efd42dcd479ecd2ull, 0x0f998901a03e4c9bull, 0x9e27db5c337760dcull, // cb 50
+  0x49a64eba0a85dc7full, 0xfcbbeaea01b76b97ull, 0x500b628bb65ca6b2ull, 0xe5aba60050d711abull, // cb 54
+  0x4dbd2f47a0fba126ull, 0x0975a779ed460f6full, 0x420daaadaaaa4945ull, 0xf8e3869cbce63304ull, // cb 58
+  0x83d64d909cb8ec4eull, 0xc74c1e0128a5adf1ull, 0x386a2ac18451846full, 0x5fefdfb8c4d40c10ull, // cb 5c
+  0x7bfe084d9150475cull, 0xb2e5df0ec6818580ull, 0xcedf9b7c5e39a88dull, 0xf6d340fda80f8af1ull, // cb 60
+  0x399750838bcc125bull, 0x827b4f16236f0cbfull, 0x3a3fc26a97c87b85ull, 0x72bc64aa12119c7cull, // cb 64
+  0xf7d5ec3786f4316cull, 0xf6b0bbcb1325ec61ull, 0x2749bf9024aebd25ull, 0xb3f98db9ebe141e0ull, // cb 68
+  0x87032e86f4a25e17ull, 0x934c5ef8447fed03ull, 0xd2c2e810aea4be8dull, 0xebb965eb3880bd0full, // cb 6c
+  0x9c70db4b670c190aull, 0xcff62703a25c7b1aull, 0x83c7fc564320388full, 0x20c83044bf393ecaull, // cb 70
+  0xd265a03e9f596ccaull, 0xa592dbda23d148d3ull, 0x20ca0536e748222eull, 0x9c10e10d92cc9052ull, // cb 74
+  0xc1a2182b44ef7f27ull, 0xc4144b8dfe0eb491ull, 0xb93bc0c2db11f2cbull, 0x514253640b19633full, // cb 78
+  0x915e94ac576edcf2ull, 0x50787c195549af27ull, 0xe5ba3664168d8781ull, 0x3f717875dfa59313ull, // cb 7c
+  0x79ea9f32001c2048ull, 0xece3b4ce4b90cd23ull, 0x83fc78f327a139feull, 0xe6c9d8ca90f134a3ull, // cb 80
+  0x7bd7dda2592e8d23ull, 0x4e5b51092ee257e4ull, 0x2d3d3f4788ca0e87ull, 0x34387f083d5d9360ull, // cb 84
+  0xfa3a7893afd7cb30ull, 0x29426d551e60ec3cull, 0x6f9b134d79c4bfb8ull, 0xbd72eb70e88ac298ull, // cb 88
+  0x25db06827a6d3877ull, 0x880e490ab8276418ull, 0xc72ffb2f7bc72438ull, 0x8afee4034d2422a2ull, // cb 8c
+  0x763c79c2e2dbafd8ull, 0xb597f2af61c10ddcull, 0xf003191f02d0857full, 0x38a27182f466884dull, // cb 90
+  0xb96ba1e2a5095874ull, 0xaa475180cdead627ull, 0x7deefe3633702e5dull, 0x060f44af2109d479ull, // cb 94
+  0xcaf203821de947c9ull, 0x9b4435152e231ecdull, 0x569c79da5454dddeull, 0xb82b1dbc4f7d2728ull, // cb 98
+  0x5f0c6f4bae555d07ull, 0xe83e8e46c5b33166ull, 0x20c1e1235a4eaecfull, 0x1fdead31c7110bf0ull, // cb 9c
+  0x035c2823c123b419ull, 0x28a00870c0aa2071ull, 0xa446d396cba1f122ull, 0xda0bba8aad5c5ab2ull, // cb a0
+  0x82fca2057ca945c6ull, 0x24d9465bf30a0e29ull, 0xec12f567aa1d27dbull, 0xcc8cafa83b93b6aeull, // cb a4
+  0x0f1c59c34783299aull, 0xf9a7c6a172d10bb3ull, 0xfb31043c5f18c13eull, 0x29b2944e1b09533dull, // cb a8
+  0x20c4979603716566ull, 0x27c64eae58108930ull, 0xe8804607316270cfull, 0x780e9f47089ac74full, // cb ac
+  0x535acfdde6085612ull, 0xc0d0f5f5831bee97ull, 0x70dd924c8d39699aull, 0x756fdb3392b5bebdull, // cb b0
+  0x40a51f0a2523ac96ull, 0x415919eba241a574ull, 0x2a8d5f6b3b393caeull, 0x0ab88b6940a9714full, // cb b4
+  0x22c6ffe38df0a846ull, 0xf5937eb9f65f6cf0ull, 0x3eb8fa28df3a27a2ull, 0xb7c81f444ebca2cfull, // cb b8
+  0x1a869512940a5850ull, 0x3eb586b9fb91cb0full, 0xe944fd065293b896ull, 0xe7fbf7d2a3717355ull, // cb bc
+  0x1f354b51ab09ebc4ull, 0xaf9576c65eac52c1ull, 0xe4f654a53f7ecb93ull, 0x89d1508b8abe4acdull, // cb c0
+  0x7fc932eceeeac997ull, 0xfa807f6f96cf3546ull, 0x7aaf0a714dd5d2f6ull, 0xbfb061aff01d0b3aull, // cb c4
+  0xd296a79d19926acaull, 0x0ef1da0170fef3d4ull, 0x8ca631620080833aull, 0xb694df1174992f63ull, // cb c8
+  0xc6f88841b4c53bceull, 0x405f0fd6e3cab030ull, 0x74221b4e3c14ffc7ull, 0x6105080307fb3706ull, // cb cc
+  0x3cf3ac6c8ee008b7ull, 0xd9ca76440543eb0cull, 0x7f9034b42385786cull, 0xadebca05fba4512full, // cb d0
+  0xa1c014ac6a86f05aull, 0x9762daefa524d110ull, 0xaf8b8604c232fb22ull, 0xc514eacc0c3df99full, // cb d4
+  0x52e3cb4453f52a6aull, 0x4c8dfb5f9e889008ull, 0xdd1cb140823a88abull, 0x00465d3402512464ull, // cb d8
+  0xeaa161ea98a894e8ull, 0x0b64a39c0ec6e2ecull, 0xb3120819411686a9ull, 0x43940c514200c9b9ull, // cb dc
+  0xa89112e481013e06ull, 0xd22f144c0e27a7a2ull, 0xd9f3b3dd0a572ba6ull, 0x4bd13b041d53f535ull, // cb e0
+  0x413a88f132af5ca6ull, 0x0e70c68b40507e95ull, 0xfc4db2220318f764ull, 0xb0a5ec123d626e74ull, // cb e4
+  0xdecb633e2548729full, 0x0297c9ba9878431aull, 0xcfada026087f2c46ull, 0x33ba070310352715ull, // cb e8
+  0x4ad94f18d4f0dea6ull, 0x5c49dc88ba8b6aa8ull, 0xf3828dce9b6f3025ull, 0xc39397988a038b52ull, // cb ec
+  0xdcb5b0d40073ee17ull, 0xa709f61374d2d0baull, 0xfac9e3b848bca44eull, 0x0acb67b84bf9f88dull, // cb f0
+  0x4da2a04d8e50fe5dull, 0x9c52848dc1cd818cull, 0x499570ff747ba0fcull, 0x3bc0ee5c9c556512ull, // cb f4
+  0x3688fbc508f9add5ull, 0xe08940467ddc962bull, 0x7ab546f7fabedc98ull, 0xf139293c68fa93cbull, // cb f8
+  0xcc86433657e5a2e2ull, 0x179a228ef53ab840ull, 0x414f6e3d7a27fc6bull, 0x7cd87cee075b173cull  // cb fc
+}};
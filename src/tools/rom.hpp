@@ -0,0 +1,186 @@
+#pragma once
+
+#include "../gb/types.h"
+
+#include <initializer_list>
+
+#include <stdint.h>
+
+// Deterministic test program for tools that have to run without a game:
+// copies and clears tile data with the usual loops, turns on the lcd with a
+// vblank handler and then spins through pseudo random register, memory and
+// bit instructions with calls into switched rom banks, a routine in hram and
+// one in wram whose closing jump reaches into the next page.
+class SyntheticRom
+{
+public:
+  static cartridge_t make(uint32_t seed = 1, bool interrupts = true)
+  {
+    SyntheticRom rom(seed);
+    rom._build(interrupts);
+    return rom._rom;
+  }
+
+private:
+  SyntheticRom(uint32_t seed)
+    : _rom(0x4000 * 4, 0x00)
+    , _seed(seed)
+  {}
+
+  uint32_t _rand(uint32_t n)
+  {
+    _seed = _seed * 1103515245 + 12345;
+    return (_seed >> 16) % n;
+  }
+
+  void _emit(std::initializer_list<reg_t> bytes)
+  {
+    for (auto b : bytes)
+      _rom[_pc++] = b;
+  }
+
+  void _jr_nz(wide_reg_t target)
+  {
+    _emit({ 0x20, static_cast<reg_t>(target - (_pc + 2)) });
+  }
+
+  void _hl_to_wram()
+  {
+    _emit({ 0x21, static_cast<reg_t>(_rand(0x100)), static_cast<reg_t>(0xC2 + _rand(8)) });
+  }
+
+  void _build(bool interrupts)
+  {
+    _rom[0x0147] = 0x01; // MBC1
+    _rom[0x0148] = 0x01; // 4 banks
+    _rom[0x0149] = 0x02; // 8KB ram
+
+    _pc = 0x0040;        // vblank: count frames and scroll
+    _emit({ 0xF5, 0xE5, 0x21, 0x00, 0xC1, 0x34, 0xF0, 0x43, 0x3C, 0xE0, 0x43, 0xE1, 0xF1, 0xD9 });
+
+    _pc = 0x0100;
+    _emit({ 0x00, 0xC3, 0x50, 0x01 });
+
+    _pc = 0x0150;
+    _emit({ 0xF3, 0x31, 0xFE, 0xFF });             // di, ld sp,fffe
+    _emit({ 0x3E, 0xE4, 0xE0, 0x47 });             // bgp
+    _emit({ 0x3E, 0xD2, 0xE0, 0x48 });             // obp0
+
+    _emit({ 0x21, 0x00, 0x20, 0x11, 0x00, 0x80, 0x01, 0x00, 0x08 });
+    auto loop = _pc;                               // tiles -> vram
+    _emit({ 0x2A, 0x12, 0x13, 0x0B, 0x78, 0xB1 });
+    _jr_nz(loop);
+
+    _emit({ 0x21, 0x00, 0x98, 0x3E, 0x05, 0x06, 0x00 });
+    loop = _pc;                                    // fill tile map
+    _emit({ 0x22, 0x05 });
+    _jr_nz(loop);
+    _emit({ 0x06, 0x00 });
+    loop = _pc;
+    _emit({ 0x22, 0x3C, 0x05 });
+    _jr_nz(loop);
+
+    _emit({ 0xAF, 0x21, 0xFF, 0xC0, 0x0E, 0xFF });
+    loop = _pc;                                    // clear wram
+    _emit({ 0x32, 0x0D });
+    _jr_nz(loop);
+
+    _emit({ 0x21, 0x80, 0xFF });                   // hram: ld a,n ; add a,b ; ld b,a ; ret
+    for (reg_t b : { 0x3E, 0x07, 0x80, 0x47, 0xC9 })
+      _emit({ 0x36, b, 0x23 });
+
+    _emit({ 0x21, 0xFD, 0xCB });                   // wram: add a,b ; ld b,a ; jp cc10
+    for (reg_t b : { 0x80, 0x47, 0xC3, 0x10, 0xCC })
+      _emit({ 0x36, b, 0x23 });
+    _emit({ 0x21, 0x10, 0xCC });                   // cc10: inc b ; ret, cc12: dec b ; ret
+    for (reg_t b : { 0x04, 0xC9, 0x05, 0xC9 })
+      _emit({ 0x36, b, 0x23 });
+
+    for (reg_t i = 0; i < 10; ++i) {               // sprites
+      _emit({ 0x21, static_cast<reg_t>(i * 4), 0xFE });
+      _emit({ 0x36, static_cast<reg_t>(0x20 + i * 8), 0x23 });
+      _emit({ 0x36, static_cast<reg_t>(0x10 + i * 12), 0x23 });
+      _emit({ 0x36, static_cast<reg_t>(i + 1), 0x23 });
+      _emit({ 0x36, static_cast<reg_t>((i % 4) * 0x20) });
+    }
+
+    _emit({ 0x3E, 0x93, 0xE0, 0x40 });             // lcd and sprites on
+    _emit({ 0x3E, static_cast<reg_t>(interrupts ? 0x01 : 0x00), 0xE0, 0xFF });
+    _emit({ 0x3E, 0x00, 0xE0, 0x0F });
+    if (interrupts)
+      _emit({ 0xFB });
+
+    auto const main = _pc;
+    for (int block = 0; block < 40; ++block) {
+      _hl_to_wram();
+
+      auto const count = 4 + _rand(26);
+      for (uint32_t i = 0; i < count; ++i) {
+        auto const kind = _rand(10);
+        if (kind < 6) {
+          auto const op = _register_op();
+          _emit({ op });
+          if (_clobbers_hl(op))
+            _hl_to_wram();
+        }
+        else if (kind < 8) {
+          static reg_t const imm[] = {
+            0x06, 0x0E, 0x16, 0x1E, 0x3E, 0xC6, 0xCE, 0xD6,
+            0xDE, 0xE6, 0xEE, 0xF6, 0xFE };
+          _emit({ imm[_rand(sizeof(imm))], static_cast<reg_t>(_rand(0x100)) });
+        }
+        else {
+          auto const cb = static_cast<reg_t>(_rand(0x100));
+          _emit({ 0xCB, cb });
+          if ((cb & 0x07) == 0x04 or (cb & 0x07) == 0x05)
+            _hl_to_wram();
+        }
+      }
+
+      _emit({ 0xC5, 0xD5, 0xCD, 0x80, 0xFF, 0xD1, 0xC1 }); // call hram
+      _emit({ 0x3E, static_cast<reg_t>(_rand(0x100)), 0xE0, 0x81 });
+      _emit({ 0xEA, static_cast<reg_t>(block * 2), 0xC3 });
+      _emit({ 0x3E, static_cast<reg_t>(0x10 + _rand(2) * 2), 0xEA, 0x00, 0xCC });
+      _emit({ 0xCD, 0xFD, 0xCB });                 // call wram with a new jump target
+      _emit({ 0x3E, static_cast<reg_t>(1 + block % 3), 0xEA, 0x00, 0x20 });
+      _emit({ 0xCD, 0x00, 0x40 });                 // call switched bank
+    }
+    _emit({ 0xC3, static_cast<reg_t>(main), static_cast<reg_t>(main >> 8) });
+
+    for (size_t i = 0x2000; i < 0x4000; ++i)
+      _rom[i] = _rand(0x100);
+
+    for (reg_t bank = 1; bank < 4; ++bank) {
+      _pc = 0x4000 * bank;
+      _emit({ 0xC6, bank, 0xEA, bank, 0xC4, 0x06, 0x10 });
+      _emit({ static_cast<reg_t>(0x80 + bank), 0x05, 0x20, 0xFC, 0xC9 });
+    }
+  }
+
+  reg_t _register_op()
+  {
+    static reg_t const ops[] = {
+      0x00, 0x03, 0x04, 0x05, 0x07, 0x09, 0x0B, 0x0C, 0x0D, 0x0F,
+      0x13, 0x14, 0x15, 0x17, 0x19, 0x1B, 0x1C, 0x1D, 0x1F, 0x27,
+      0x2F, 0x34, 0x35, 0x37, 0x3C, 0x3D, 0x3F };
+
+    auto const n = _rand(sizeof(ops) + 0x80);
+    if (n < sizeof(ops))
+      return ops[n];
+
+    auto const op = static_cast<reg_t>(0x40 + n - sizeof(ops));
+    return op == 0x76 ? 0x00 : op;
+  }
+
+  static bool _clobbers_hl(reg_t op)
+  {
+    return
+      op == 0x09 or op == 0x19 or (op >= 0x60 and op < 0x70) or
+      (op & 0xF0) == 0x20;
+  }
+
+private:
+  cartridge_t _rom;
+  uint32_t    _seed;
+  size_t      _pc = 0;
+};
@@ -0,0 +1,129 @@
+#include "../gb/gb.hpp"
+#include "../gb/hash.hpp"
+#include "../gb/shards.hpp"
+#include "rom.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cstdlib>
+
+// Measures how many frames per second worker processes deliver to one
+// consumer through shared memory.
+//
+//   yagbe-shards [--workers N] [--machines N] [--frames N] [--slots N]
+//                [--consume US] [--hashes] [ROM]
+//
+// --workers defaults to one per core, --machines to 64 and --frames to 600
+// per machine. --consume makes the consumer spend that many microseconds
+// on every frame of a worker to show the workers being held back. --hashes
+// prints a hash of every machine's last screen and the LCDC and LY
+// registers observed with it. The machines run without input, so the hash
+// matches what a single machine shows after as many frames.
+// Without a rom a synthetic program is used.
+
+int main(int argc, char** argv)
+{
+  size_t      workers  = std::max(std::thread::hardware_concurrency(), 1u);
+  size_t      machines = 64;
+  uint64_t    frames   = 600;
+  size_t      slots    = Shards::DEFAULT_SLOTS;
+  unsigned    consume  = 0;
+  bool        hashes   = false;
+  std::string rom_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--workers" and i + 1 < argc)
+      workers = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--machines" and i + 1 < argc)
+      machines = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--frames" and i + 1 < argc)
+      frames = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--slots" and i + 1 < argc)
+      slots = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--consume" and i + 1 < argc)
+      consume = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--hashes")
+      hashes = true;
+    else
+      rom_path = arg;
+  }
+
+  auto const rom = rom_path.empty()
+    ? RomImage::copy(SyntheticRom::make())
+    : RomImage::open(rom_path);
+
+  GB gb;
+  auto const error = gb.insert_rom(rom);
+  if (error.is_set()) {
+    printf("%s\n", error.text().c_str());
+    return EXIT_FAILURE;
+  }
+  gb.power_on(true);
+
+  Shards shards;
+  auto const start_error = shards.start(gb, machines, workers, { 0xFF40, 0xFF44 }, slots);
+  if (start_error.is_set()) {
+    printf("SHARDS: %s\n", start_error.text().c_str());
+    return EXIT_FAILURE;
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+
+  // a worker's frame is one step of all its machines
+  std::vector<uint64_t> screens(machines);
+  std::vector<reg_t>    observed(machines * 2);
+  uint64_t received = 0;
+  size_t   done     = 0;
+  while (done < shards.workers()) {
+    Shards::Frame frame;
+    auto const next_error = shards.next(frame);
+    if (next_error.is_set()) {
+      printf("SHARDS: %s\n", next_error.text().c_str());
+      return EXIT_FAILURE;
+    }
+
+    if (frame.step < frames) {
+      for (size_t i = 0; i < frame.count; ++i) {
+        auto const machine = frame.first + i;
+        observed[machine * 2]     = frame.observations[i * 2];
+        observed[machine * 2 + 1] = frame.observations[i * 2 + 1];
+        if (hashes and frame.step + 1 == frames)
+          screens[machine] = hash(frame.screens + i * Shards::SCREEN_SIZE, Shards::SCREEN_SIZE);
+      }
+
+      received += frame.count;
+      if (frame.step + 1 == frames)
+        ++done;
+
+      if (consume)
+        std::this_thread::sleep_for(std::chrono::microseconds(consume));
+    }
+
+    shards.release(frame);
+  }
+
+  auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  auto const stalls  = shards.stalls();
+  shards.stop();
+
+  for (size_t machine = 0; hashes and machine < machines; ++machine)
+    printf(
+      "SCREEN: %zu %016llx LCDC %02x LY %02x\n",
+      machine,
+      static_cast<unsigned long long>(screens[machine]),
+      observed[machine * 2],
+      observed[machine * 2 + 1]);
+
+  printf(
+    "SHARDS: %zu workers, %zu machines, %llu frames in %.3f s, %.1f frames/s, %llu stalls\n",
+    shards.workers(),
+    machines,
+    static_cast<unsigned long long>(received),
+    seconds,
+    received / seconds,
+    static_cast<unsigned long long>(stalls));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include "../gb/mm.hpp"
+#include "../gb/opcodes.hpp"
+#include "../gb/trace.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <cstdlib>
+
+// Prints a trace written by yagbe --trace, one instruction per line.
+//
+//   yagbe-trace [--last N] TRACE
+
+int main(int argc, char** argv)
+{
+  size_t      last = 0;
+  std::string trace_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--last" and i + 1 < argc)
+      last = std::atoi(argv[++i]);
+    else
+      trace_path = arg;
+  }
+
+  if (trace_path.empty())
+    return EXIT_FAILURE;
+
+  std::ifstream s_trace(
+    trace_path,
+    std::ios::in | std::ios::binary);
+
+  std::vector<reg_t> const data(
+    (std::istreambuf_iterator<char>(s_trace)),
+    std::istreambuf_iterator<char>());
+
+  std::vector<Trace::Record> records;
+  auto const error = Trace::load(data, records);
+  if (error.is_set()) {
+    printf("%s\n", error.text().c_str());
+    return EXIT_FAILURE;
+  }
+
+  auto const first = last and last < records.size() ? records.size() - last : 0;
+  for (auto i = first; i < records.size(); ++i) {
+    auto const& r = records[i];
+    reg_t const bytes[] = { r.op, r.b1, r.b2 };
+    auto const len = Opcodes::length(r.op);
+
+    printf("%12llu ", static_cast<unsigned long long>(r.cycle));
+    if (r.bank == MM::BANK_BOOT)
+      printf("boot:");
+    else if (r.bank == MM::BANK_RAM)
+      printf(" ram:");
+    else
+      printf("  %02x:", r.bank);
+    printf("%04x ", r.pc);
+
+    for (size_t b = 0; b < 3; ++b) {
+      if (b < len)
+        printf(" %02x", bytes[b]);
+      else
+        printf("   ");
+    }
+
+    printf(
+      "  %-12s af:%04x bc:%04x de:%04x hl:%04x sp:%04x %c%c%c%c %s LCDC:%02x\n",
+      Opcodes::name(r.op, r.b1),
+      r.af, r.bc, r.de, r.hl, r.sp,
+      (r.af & 0x80 ? 'Z' : '_'),
+      (r.af & 0x40 ? 'S' : '_'),
+      (r.af & 0x20 ? 'H' : '_'),
+      (r.af & 0x10 ? 'C' : '_'),
+      r.ime ? "EI" : "DI",
+      r.lcdc);
+  }
+
+  return EXIT_SUCCESS;
+}
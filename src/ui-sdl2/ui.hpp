@@ -8,6 +8,12 @@
 class UiSDL
 {
 public:
+  enum class Request {
+    None,
+    SaveState, // F5
+    LoadState, // F7
+  };
+
   UiSDL(GB& gb, int scale, bool memory, bool tiles)
     : _gb(gb)
     , _scale(scale)
@@ -44,62 +50,93 @@ public:
     return _running;
   }
 
+  // what the user asked for since the last call, left to main
+  Request take_request()
+  {
+    auto const request = _request;
+    _request = Request::None;
+    return request;
+  }
+
+  // while the rewind key is held
+  bool rewinding() const
+  {
+    return _rewinding;
+  }
+
   void tick()
   {
     if (_gb.is_v_blank_completed()) {
-      SDL_Event event;
-      while(SDL_PollEvent(&event)) {
-        switch(event.type) {
-        case SDL_KEYDOWN:
-          switch (event.key.keysym.sym) {
-          case SDLK_LEFT:  _gb.left(true); break;
-
-          case SDLK_RIGHT: _gb.right(true); break;
-          case SDLK_UP:    _gb.up(true); break;
-          case SDLK_DOWN:  _gb.down(true); break;
-
-          case SDLK_a:  _gb.a(true); break;
-          case SDLK_s:  _gb.b(true); break;
-          case SDLK_y:  _gb.select(true); break;
-          case SDLK_x:  _gb.start(true); break;
-          }
-          break;
-        case SDL_KEYUP:
-          switch (event.key.keysym.sym) {
-          case SDLK_LEFT:  _gb.left(false); break;
-          case SDLK_RIGHT: _gb.right(false); break;
-          case SDLK_UP:    _gb.up(false); break;
-          case SDLK_DOWN:  _gb.down(false); break;
-
-          case SDLK_a:  _gb.a(false); break;
-          case SDLK_s:  _gb.b(false); break;
-          case SDLK_y:  _gb.select(false); break;
-          case SDLK_x:  _gb.start(false); break;
-          }
-          break;
-        case SDL_QUIT:
-          _running= false;
-          break;
+      poll();
+      draw();
+    }
+  }
+
+  // input goes to the machine right away
+  void poll()
+  {
+    SDL_Event event;
+    while(SDL_PollEvent(&event)) {
+      switch(event.type) {
+      case SDL_KEYDOWN:
+        switch (event.key.keysym.sym) {
+        case SDLK_LEFT:  _gb.left(true); break;
+
+        case SDLK_RIGHT: _gb.right(true); break;
+        case SDLK_UP:    _gb.up(true); break;
+        case SDLK_DOWN:  _gb.down(true); break;
+
+        case SDLK_a:  _gb.a(true); break;
+        case SDLK_s:  _gb.b(true); break;
+        case SDLK_y:  _gb.select(true); break;
+        case SDLK_x:  _gb.start(true); break;
+
+        case SDLK_F5: _request = Request::SaveState; break;
+        case SDLK_F7: _request = Request::LoadState; break;
+
+        case SDLK_r:  _rewinding = true; break;
+        }
+        break;
+      case SDL_KEYUP:
+        switch (event.key.keysym.sym) {
+        case SDLK_LEFT:  _gb.left(false); break;
+        case SDLK_RIGHT: _gb.right(false); break;
+        case SDLK_UP:    _gb.up(false); break;
+        case SDLK_DOWN:  _gb.down(false); break;
+
+        case SDLK_a:  _gb.a(false); break;
+        case SDLK_s:  _gb.b(false); break;
+        case SDLK_y:  _gb.select(false); break;
+        case SDLK_x:  _gb.start(false); break;
+
+        case SDLK_r:  _rewinding = false; break;
         }
+        break;
+      case SDL_QUIT:
+        _running= false;
+        break;
       }
+    }
+  }
 
-      if (_main_ren) {
-        _render_main(_main_ren, _gb);
-        SDL_RenderPresent(_main_ren);
-      }
+  void draw()
+  {
+    if (_main_ren) {
+      _render_main(_main_ren, _gb);
+      SDL_RenderPresent(_main_ren);
+    }
 
-      if (_mem_ren) {
-        _render_memory(_mem_ren, _gb);
-        SDL_RenderPresent(_mem_ren);
-      }
+    if (_mem_ren) {
+      _render_memory(_mem_ren, _gb);
+      SDL_RenderPresent(_mem_ren);
+    }
 
-      if (_tile_ren) {
-        _render_tiles(_tile_ren, _gb, _tile_pattern_1_start);
-        SDL_RenderPresent(_tile_ren);
+    if (_tile_ren) {
+      _render_tiles(_tile_ren, _gb, _tile_pattern_1_start);
+      SDL_RenderPresent(_tile_ren);
 
-        _render_tiles(_tile2_ren, _gb, _tile_pattern_2_start);
-        SDL_RenderPresent(_tile2_ren);
-      }
+      _render_tiles(_tile2_ren, _gb, _tile_pattern_2_start);
+      SDL_RenderPresent(_tile2_ren);
     }
   }
 
@@ -214,7 +251,7 @@ private:
     rect.w = _scale;
     rect.h = _scale;
 
-    auto const screen = gb.screen();
+    auto const& screen = gb.screen();
     for (size_t i = 0; i < screen.size(); ++i) {
       if (not _refresh and screen[i] == _last_screen[i])
         continue;
@@ -346,6 +383,8 @@ private:
   GB& _gb;
 
   bool      _running = true;
+  Request   _request = Request::None;
+  bool      _rewinding = false;
   int const _scale;
 
   SDL_Window*   _main_win = nullptr;